@@ -0,0 +1,60 @@
+import argparse
+import json
+import os
+import shutil
+import sys
+
+parser = argparse.ArgumentParser(
+    description="Compare glynth_bench results against a stored baseline"
+)
+parser.add_argument("current", help="JSON written by glynth_bench")
+parser.add_argument("--baseline", default="bench/baseline.json")
+parser.add_argument(
+    "--threshold",
+    type=float,
+    default=0.10,
+    help="relative slowdown that counts as a regression (default: 0.10)",
+)
+parser.add_argument(
+    "--update",
+    action="store_true",
+    help="replace the baseline with the current results",
+)
+args = parser.parse_args()
+
+if args.update:
+    os.makedirs(os.path.dirname(args.baseline) or ".", exist_ok=True)
+    shutil.copyfile(args.current, args.baseline)
+    print(f"Updated {args.baseline}")
+    sys.exit(0)
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+baseline = load(args.baseline)
+current = load(args.current)
+
+regressions = []
+print(f"{'benchmark':<40} {'baseline':>12} {'current':>12} {'change':>8}")
+for name, result in current.items():
+    if name not in baseline:
+        print(f"{name:<40} {'-':>12} {result['ns_per_iter']:>12.1f} {'new':>8}")
+        continue
+    before = baseline[name]["ns_per_iter"]
+    after = result["ns_per_iter"]
+    change = (after - before) / before
+    flag = ""
+    if change > args.threshold:
+        regressions.append(name)
+        flag = "  <-- regression"
+    print(f"{name:<40} {before:>12.1f} {after:>12.1f} {change:>+8.1%}{flag}")
+
+for name in baseline.keys() - current.keys():
+    print(f"{name:<40} missing from current results")
+
+if regressions:
+    print(f"\n{len(regressions)} regression(s) above {args.threshold:.0%}")
+    sys.exit(1)
@@ -3,15 +3,17 @@
 // TODO make this a uniform
 const vec3 ACCENT = vec3(0.9607843137, 0.7529411765, 0.137254902);
 
-uniform sampler2D u_bitmap;
+// Signed distance fields from FreeType, where 0.5 is the edge of the glyph
+// and values increase inside it
+uniform sampler2D u_atlas;
 
 in vec2 texcoord;
 out vec4 frag_color;
 
 void main() {
-    // need to flip vertically due to texcoord/freetype mismatch
-    vec2 uv = vec2(texcoord.x, 1 - texcoord.y);
-    // red channel of bitmap contains the alpha
-    float alpha = texture(u_bitmap, uv).r;
+    float distance = texture(u_atlas, texcoord).r;
+    // Antialias over about one screen pixel, whatever size the text is
+    float width = 0.7 * fwidth(distance);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
     frag_color = vec4(ACCENT, alpha);
 }
@@ -0,0 +1,11 @@
+#version 330 core
+
+// A layer rendered earlier at the same size as the viewport
+uniform sampler2D u_layer;
+
+in vec2 texcoord;
+out vec4 frag_color;
+
+void main() {
+    frag_color = texture(u_layer, texcoord);
+}
@@ -3,11 +3,16 @@
 #define M_PI 3.1415926535897932384626433832795
 const vec3 ACCENT = vec3(0.9607843137, 0.7529411765, 0.137254902);
 
-uniform vec2 u_resolution;
 // negative means not focused
 uniform float u_time;
 // samples of the outline, rg -> xy
 uniform sampler1D u_samples;
+// for each grid cell, the first index into u_segments and the count
+uniform usampler2D u_cells;
+// index of the first sample of each segment near each cell
+uniform usamplerBuffer u_segments;
+// side of a grid cell in pixels
+uniform float u_cell_size;
 // whether the outline is valid
 uniform bool u_has_outline;
 // bounds of cursor block
@@ -15,6 +20,8 @@ uniform vec2 u_outline_glyph_corner;
 uniform vec2 u_outline_glyph_size;
 
 in vec2 texcoord;
+// Size of the rect in pixels
+in vec2 resolution;
 out vec4 frag_color;
 
 // from https://www.shadertoy.com/view/Wlfyzl
@@ -36,18 +43,21 @@ float sd_box(in vec2 p, in vec2 b) {
 
 void main() {
     frag_color = vec4(0, 0, 0, 1);
-    vec2 p = u_resolution * texcoord;
+    vec2 p = resolution * texcoord;
     if(u_has_outline) {
-        int num_samples = textureSize(u_samples, 0);
-        // draw lines from a -> b
-        vec2 a = texelFetch(u_samples, 0, 0).rg;
-        for(int i = 1; i < num_samples; i++) {
-            vec2 b = texelFetch(u_samples, i, 0).rg;
+        // only the segments listed for this pixel's cell can reach it
+        ivec2 num_cells = textureSize(u_cells, 0);
+        ivec2 cell = min(ivec2(p / u_cell_size), num_cells - 1);
+        uvec2 range = texelFetch(u_cells, cell, 0).rg;
+        for(uint j = range.x; j < range.x + range.y; j++) {
+            int i = int(texelFetch(u_segments, int(j)).r);
+            // draw lines from a -> b
+            vec2 a = texelFetch(u_samples, i, 0).rg;
+            vec2 b = texelFetch(u_samples, i + 1, 0).rg;
             float d = sd_line_segment(p, a, b) - 0.5;
             float s = 1 - smoothstep(0.0, 1.0, d);
             // handle extra overdraw by merging with max instead of a sum
             frag_color.xyz = max(frag_color.xyz, s * ACCENT);
-            a = b;
         }
 
     }
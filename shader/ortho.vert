@@ -1,8 +1,9 @@
 #version 330 core
-layout(location = 0) in vec2 pos;
+// Corner of the unit quad, stretched over the viewport
+layout(location = 0) in vec2 corner;
 out vec2 texcoord;
 
 void main() {
-    texcoord = 0.5 * pos.xy + vec2(0.5);
-    gl_Position = vec4(pos.x, pos.y, 0.0, 1.0);
+    texcoord = corner;
+    gl_Position = vec4(2.0 * corner - vec2(1.0), 0.0, 1.0);
 }
@@ -3,9 +3,9 @@
 // design parameters
 const vec4 ACCENT = vec4(0.9607843137, 0.7529411765, 0.137254902, 0.0);
 
-uniform vec2 u_resolution;
-
 in vec2 texcoord;
+// Size of the rect in pixels
+in vec2 resolution;
 out vec4 frag_color;
 
 // see https://www.shadertoy.com/view/Wlfyzl
@@ -22,7 +22,7 @@ void main() {
     // create stippled pattern by thresholding a square wave
     float in_stipple = step(-0.05, uv.x);
     frag_color += in_stipple * ACCENT;
-    vec2 p = texcoord * u_resolution;
+    vec2 p = texcoord * resolution;
     // draw line and make stippled by using as alpha for pattern
     float dist_line = line_segment(p, vec2(61, 31), vec2(172, 31));
     frag_color.a = 1 - smoothstep(0.0, 1.0, dist_line);
@@ -0,0 +1,19 @@
+#version 330 core
+// Corner of the unit quad, shared by every instance
+layout(location = 0) in vec2 corner;
+// Bottom left corner and size in window pixels, per instance
+layout(location = 1) in vec4 rect;
+layout(location = 2) in float instance_value;
+out vec2 texcoord;
+out vec2 resolution;
+flat out float value;
+
+uniform mat4 u_projection;
+
+void main() {
+    texcoord = corner;
+    resolution = rect.zw;
+    value = instance_value;
+    vec2 pos = rect.xy + corner * rect.zw;
+    gl_Position = u_projection * vec4(pos.x, pos.y, 0.0, 1.0);
+}
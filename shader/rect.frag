@@ -1,8 +1,8 @@
 #version 330 core
 
-uniform vec2 u_resolution;
-
 in vec2 texcoord;
+// Size of the rect in pixels
+in vec2 resolution;
 out vec4 frag_color;
 
 void main() {
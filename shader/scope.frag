@@ -2,31 +2,33 @@
 
 const vec3 ACCENT = vec3(0.9607843137, 0.7529411765, 0.137254902);
 
-uniform sampler1D u_samples;
-uniform vec2 u_resolution;
+// lowest and highest point of the trace in each physical pixel column,
+// rg -> (min, max)
+uniform sampler1D u_columns;
 
 in vec2 texcoord;
+// Size of the rect in pixels
+in vec2 resolution;
 out vec4 frag_color;
 
-// from https://www.shadertoy.com/view/Wlfyzl
-float sd_line_segment(in vec2 p, in vec2 a, in vec2 b) {
-    vec2 ba = b - a;
-    vec2 pa = p - a;
-    float h = clamp(dot(pa, ba) / dot(ba, ba), 0.0, 1.0);
-    return length(pa - h * ba);
-}
-
 void main() {
     frag_color = vec4(0, 0, 0, 1);
-    vec2 p = u_resolution * texcoord;
-    int num_samples = textureSize(u_samples, 0);
-    // draw lines from a -> b. see lissajous.frag
-    vec2 a = vec2(0, texelFetch(u_samples, 0, 0).r);
-    for(int i = 1; i < num_samples; i++) {
-        vec2 b = vec2(i, texelFetch(u_samples, i, 0).r);
-        float d = sd_line_segment(p, a, b) - 0.5;
+    vec2 p = resolution * texcoord;
+    int num_columns = textureSize(u_columns, 0);
+    // columns per pixel, more than 1 on HiDPI displays
+    float scale = float(num_columns) / resolution.x;
+    int column = int(p.x * scale);
+    // columns up to a pixel away too, so edges are smoothed horizontally
+    int reach = int(ceil(scale));
+    int first = max(column - reach, 0);
+    int last = min(column + reach, num_columns - 1);
+    for(int i = first; i <= last; i++) {
+        vec2 extent = texelFetch(u_columns, i, 0).rg;
+        // distance to the vertical segment through the column's center
+        float dx = p.x - (float(i) + 0.5) / scale;
+        float dy = max(max(extent.x - p.y, p.y - extent.y), 0.0);
+        float d = length(vec2(dx, dy)) - 0.5;
         float s = 1 - smoothstep(0.0, 1.0, d);
         frag_color.xyz = max(frag_color.xyz, s * ACCENT);
-        a = b;
     }
 }
@@ -0,0 +1,11 @@
+#version 330 core
+
+const vec3 ACCENT = vec3(0.9607843137, 0.7529411765, 0.137254902);
+
+in float brightness;
+out vec4 frag_color;
+
+void main() {
+    // blended additively, so dense parts of the trace glow
+    frag_color = vec4(ACCENT, 0.25 * brightness);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+// left and right output, streamed into a ring of points
+layout(location = 0) in vec2 frame;
+out float brightness;
+
+uniform mat4 u_projection;
+// bottom left corner and size of the scope in window pixels
+uniform vec2 u_corner;
+uniform vec2 u_size;
+// index after the newest point, and the number of points in the ring
+uniform int u_head;
+uniform int u_capacity;
+// samples for a point to fade to 1/e, and samples since the newest arrived
+uniform float u_persistence;
+uniform float u_idle;
+
+void main() {
+    int age = (u_head - 1 - gl_VertexID + u_capacity) % u_capacity;
+    brightness = exp(-(float(age) + u_idle) / u_persistence);
+    vec2 pos = u_corner + (0.5 + 0.5 * clamp(frame, -1.0, 1.0)) * u_size;
+    gl_Position = u_projection * vec4(pos.x, pos.y, 0.0, 1.0);
+}
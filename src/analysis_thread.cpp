@@ -0,0 +1,29 @@
+#include "analysis_thread.h"
+
+AnalysisThread::AnalysisThread() : juce::Thread("Glynth Analysis") {
+  startThread(juce::Thread::Priority::low);
+}
+
+AnalysisThread::~AnalysisThread() { stopThread(1000); }
+
+void AnalysisThread::addTap(AnalysisTap& tap) {
+  const juce::ScopedLock lock(m_lock);
+  m_taps.push_back(&tap);
+}
+
+void AnalysisThread::removeTap(AnalysisTap& tap) {
+  const juce::ScopedLock lock(m_lock);
+  std::erase(m_taps, &tap);
+}
+
+void AnalysisThread::run() {
+  while (!threadShouldExit()) {
+    {
+      const juce::ScopedLock lock(m_lock);
+      for (auto* tap : m_taps) {
+        tap->analyze();
+      }
+    }
+    wait(1000 / s_rate_hz);
+  }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+// Something that pulls data off of the audio thread for visualization
+class AnalysisTap {
+public:
+  virtual ~AnalysisTap() = default;
+  // Called periodically from the analysis thread
+  virtual void analyze() = 0;
+};
+
+// Single worker that drains every registered tap, so visualization work
+// doesn't compete with UI events on the message thread. Shared by all plugin
+// instances through juce::SharedResourcePointer<AnalysisThread>
+class AnalysisThread : private juce::Thread {
+public:
+  static constexpr int s_rate_hz = 60;
+
+  AnalysisThread();
+  ~AnalysisThread() override;
+  void addTap(AnalysisTap& tap);
+  // Blocks until the tap is no longer being analyzed
+  void removeTap(AnalysisTap& tap);
+
+private:
+  void run() override;
+
+  juce::CriticalSection m_lock;
+  std::vector<AnalysisTap*> m_taps;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisThread)
+};
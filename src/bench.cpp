@@ -0,0 +1,260 @@
+#include "error.h"
+#include "fonts.h"
+#include "outliner.h"
+#include "processor.h"
+
+#include <chrono>
+#include <fmt/base.h>
+#include <fmt/format.h>
+#include <fmt/os.h>
+#include <freetype/freetype.h>
+
+// Microbenchmarks for the DSP and outline hot paths. Results are written as
+// JSON so that script/compare_bench.py can check them against a baseline.
+//
+//   glynth_bench [--out=out/bench.json] [--filter=<substring>]
+//       [--min-time=0.2]
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string name;
+  size_t iterations;
+  double ns_per_iter;
+  // Samples (or other items) processed per iteration, if meaningful
+  size_t items_per_iter;
+};
+
+// Keeps the compiler from optimizing away work whose result is unused
+template <typename T>
+inline void doNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class Runner {
+public:
+  Runner(std::string filter, double min_seconds)
+      : m_filter(std::move(filter)), m_min_seconds(min_seconds) {}
+
+  // Times f, doubling the iteration count until a batch takes at least
+  // m_min_seconds. Reports the median of several such batches
+  template <typename F>
+  void run(const std::string& name, size_t items_per_iter, F&& f) {
+    if (!m_filter.empty() && name.find(m_filter) == std::string::npos) {
+      return;
+    }
+    f(); // Warm up caches and lazily initialized state
+    size_t iterations = 1;
+    double seconds = 0;
+    while ((seconds = time(f, iterations)) < m_min_seconds) {
+      iterations *= 2;
+    }
+    std::array<double, s_num_repeats> ns_per_iter;
+    ns_per_iter[0] = seconds * 1e9 / static_cast<double>(iterations);
+    for (size_t i = 1; i < s_num_repeats; i++) {
+      ns_per_iter[i] =
+          time(f, iterations) * 1e9 / static_cast<double>(iterations);
+    }
+    std::sort(ns_per_iter.begin(), ns_per_iter.end());
+    auto& result = m_results.emplace_back(Result{
+        .name = name,
+        .iterations = iterations,
+        .ns_per_iter = ns_per_iter[s_num_repeats / 2],
+        .items_per_iter = items_per_iter,
+    });
+    fmt::println(stderr, "{:<40} {:>14.1f} ns/iter", result.name,
+                 result.ns_per_iter);
+  }
+
+  void write(const std::string& path) const {
+    auto out = fmt::output_file(path);
+    out.print("{{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < m_results.size(); i++) {
+      auto& r = m_results[i];
+      out.print(R"(    {{"name": "{}", "iterations": {}, "ns_per_iter": {}, )"
+                R"("items_per_iter": {}}}{})",
+                r.name, r.iterations, r.ns_per_iter, r.items_per_iter,
+                i + 1 < m_results.size() ? ",\n" : "\n");
+    }
+    out.print("  ]\n}}\n");
+  }
+
+private:
+  static constexpr size_t s_num_repeats = 5;
+
+  template <typename F>
+  static double time(F& f, size_t iterations) {
+    auto start = clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      f();
+    }
+    return std::chrono::duration<double>(clock::now() - start).count();
+  }
+
+  std::string m_filter;
+  double m_min_seconds;
+  std::vector<Result> m_results;
+};
+
+std::string repeatText(size_t length) {
+  std::string_view pattern = "Glynth ";
+  std::string text;
+  for (size_t i = 0; i < length; i++) {
+    text += pattern[i % pattern.size()];
+  }
+  return text;
+}
+
+void fillNoise(juce::AudioBuffer<float>& buffer) {
+  juce::Random random(42);
+  for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
+    for (int i = 0; i < buffer.getNumSamples(); i++) {
+      buffer.setSample(ch, i, random.nextFloat() - 0.5f);
+    }
+  }
+}
+
+void benchOutline(Runner& runner, FT_Face face) {
+  // The outline builder only falls back to FreeType for text the pack
+  // doesn't cover
+  auto& pack = OutlinePack::getBundled();
+  auto* pack_face = pack.findFace("SplineSansMono-Medium");
+  for (size_t length : std::array<size_t, 4>{1, 8, 32, 128}) {
+    auto text = repeatText(length);
+    runner.run(fmt::format("outline/construct/{}", length), length, [&] {
+      Outline outline(text, face, 20);
+      doNotOptimize(outline);
+    });
+    if (pack_face != nullptr && pack.covers(*pack_face, text)) {
+      runner.run(fmt::format("outline/pack/{}", length), length, [&] {
+        Outline outline(text, pack, *pack_face, 20);
+        doNotOptimize(outline);
+      });
+    }
+    Outline outline(text, face, 20);
+    runner.run(fmt::format("outline/sample/{}", length), 512, [&] {
+      auto samples = outline.sample(512);
+      doNotOptimize(samples.data());
+    });
+  }
+}
+
+void benchSynth(Runner& runner, GlynthProcessor& processor) {
+  constexpr int block_size = 512;
+  for (size_t num_voices : std::array<size_t, 5>{1, 8, 32, 128, 512}) {
+    Synth synth(processor, processor.getParamById("attack"),
+                processor.getParamById("decay"), num_voices);
+    synth.prepareToPlay(44100, block_size);
+    // Picks up the processor's outline in the first processBlock
+    juce::AudioBuffer<float> buffer(2, block_size);
+    // Start every voice once, then time blocks with no MIDI
+    juce::MidiBuffer midi;
+    for (size_t i = 0; i < num_voices; i++) {
+      midi.addEvent(juce::MidiMessage::noteOn(1, 24 + static_cast<int>(i % 96),
+                                              1.0f),
+                    0);
+    }
+    synth.processBlock(buffer, midi);
+    midi.clear();
+    runner.run(fmt::format("synth/voices/{}", num_voices), block_size, [&] {
+      synth.processBlock(buffer, midi);
+      doNotOptimize(buffer.getReadPointer(0));
+    });
+  }
+}
+
+void benchInstantiation(Runner& runner) {
+  // Another instance keeps the shared font registry and outline cache alive,
+  // as in a session with the plugin already loaded
+  GlynthProcessor other;
+  other.waitForOutline(10000);
+  runner.run("instantiate/construct", 1, [] {
+    GlynthProcessor processor;
+    doNotOptimize(processor);
+  });
+  // Includes waiting for the worker to publish the (cached) default outline
+  runner.run("instantiate/ready", 1, [] {
+    GlynthProcessor processor;
+    processor.waitForOutline(10000);
+    doNotOptimize(processor);
+  });
+}
+
+void benchSubProcessors(Runner& runner, GlynthProcessor& processor) {
+  auto& freq = processor.getParamById("lpf_freq");
+  auto& res = processor.getParamById("lpf_res");
+  juce::MidiBuffer midi;
+  for (int block_size : {64, 256, 1024}) {
+    auto n = static_cast<size_t>(block_size);
+    juce::AudioBuffer<float> noise(2, block_size);
+    fillNoise(noise);
+    juce::AudioBuffer<float> buffer(2, block_size);
+
+    LowPassFilter filter(processor, &freq, &res);
+    filter.prepareToPlay(44100, block_size);
+    runner.run(fmt::format("biquad/block/{}", block_size), n, [&] {
+      buffer.makeCopyOf(noise, true);
+      filter.processBlock(buffer, midi);
+      doNotOptimize(buffer.getReadPointer(0));
+    });
+
+    CorruptionSilencer silencer(processor);
+    runner.run(fmt::format("silencer/block/{}", block_size), n, [&] {
+      buffer.makeCopyOf(noise, true);
+      silencer.processBlock(buffer, midi);
+      doNotOptimize(buffer.getReadPointer(0));
+    });
+
+    TriggerHandler trigger_handler(processor, 0);
+    trigger_handler.prepareToPlay(44100, block_size);
+    runner.run(fmt::format("trigger/block/{}", block_size), n, [&] {
+      trigger_handler.processBlock(noise, midi);
+    });
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  juce::ScopedJuceInitialiser_GUI juce_initialiser;
+  juce::ArgumentList args(argc, argv);
+  auto option = [&args](juce::StringRef name, juce::String fallback) {
+    return args.containsOption(name) ? args.getValueForOption(name) : fallback;
+  };
+  auto out_path = juce::File::getCurrentWorkingDirectory().getChildFile(
+      option("--out", "out/bench.json"));
+  out_path.getParentDirectory().createDirectory();
+  Runner runner(option("--filter", "").toStdString(),
+                option("--min-time", "0.2").getDoubleValue());
+
+  FT_Error err;
+  FT_Library library;
+  if ((err = FT_Init_FreeType(&library))) {
+    throw FreetypeError(FT_Error_String(err));
+  }
+  FT_Face face;
+  if ((err = FT_New_Memory_Face(
+           library,
+           reinterpret_cast<const FT_Byte*>(fonts::SplineSansMonoMedium_ttf),
+           fonts::SplineSansMonoMedium_ttfSize, 0, &face))) {
+    throw FreetypeError(FT_Error_String(err));
+  }
+
+  benchInstantiation(runner);
+  {
+    GlynthProcessor processor;
+    processor.waitForOutline(10000);
+    benchOutline(runner, face);
+    benchSynth(runner, processor);
+    benchSubProcessors(runner, processor);
+  }
+
+  runner.write(out_path.getFullPathName().toStdString());
+  fmt::println(stderr, R"(Wrote "{}")",
+               out_path.getFullPathName().toStdString());
+  FT_Done_Face(face);
+  FT_Done_FreeType(library);
+  return 0;
+}
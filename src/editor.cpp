@@ -3,39 +3,60 @@
 #include "logger.h"
 #include "processor.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <fmt/base.h>
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 #include <glm/ext.hpp>
+#include <utility>
 
-GlynthEditor::GlynthEditor(GlynthProcessor& p, FontManager& font_manager)
-    : AudioProcessorEditor(&p), m_processor_ref(p), m_shader_manager(m_context),
-      m_font_manager(font_manager) {
+GlynthEditor::GlynthEditor(GlynthProcessor& p)
+    : AudioProcessorEditor(&p), m_processor_ref(p),
+      m_shader_manager(m_context) {
   // Must set size for window to show properly
   setSize(840, 473);
   setOpaque(true);
   m_context.setOpenGLVersionRequired(juce::OpenGLContext::openGL3_2);
   m_context.setRenderer(this);
-  m_context.setContinuousRepainting(true);
+  // Frames are triggered from timerCallback instead
+  m_context.setContinuousRepainting(false);
   m_context.attachTo(*this);
+  for (auto* param : p.getParameters()) {
+    param->addListener(this);
+  }
+  startTimerHz(s_frame_rate_hz);
+}
+GlynthEditor::~GlynthEditor() {
+  stopTimer();
+  for (auto* param : m_processor_ref.getParameters()) {
+    param->removeListener(this);
+  }
+  m_context.detach();
 }
-GlynthEditor::~GlynthEditor() { m_context.detach(); }
 
 void GlynthEditor::paint(juce::Graphics&) {}
 
 void GlynthEditor::newOpenGLContextCreated() {
   m_font_manager.setContext(m_context);
-  m_font_manager.buildBitmaps("SplineSansMono-Bold", 20);
-  m_font_manager.buildBitmaps("SplineSansMono-Medium", 10);
+  m_font_manager.addFace("SplineSansMono-Bold");
+  m_font_manager.addFace("SplineSansMono-Medium");
   m_shader_manager.addProgram("bg", "ortho", "vt220");
-  m_shader_manager.addProgram("knob", "rect", "knob");
+  m_shader_manager.addProgram("layer", "ortho", "layer");
+  m_shader_manager.addProgram("knob", "quad", "knob");
   m_shader_manager.addProgram("char", "rect", "char");
-  m_shader_manager.addProgram("param", "rect", "param");
-  m_shader_manager.addProgram("lissajous", "rect", "lissajous");
-  m_shader_manager.addProgram("scope", "rect", "scope");
+  m_quad_batch = std::make_unique<QuadBatch>(m_shader_manager);
+  m_text_batch = std::make_unique<TextBatch>(m_shader_manager, "char");
+  m_layer_component = std::make_unique<LayerComponent>(*this, "layer");
+  m_shader_manager.addProgram("param", "quad", "param");
+  m_shader_manager.addProgram("lissajous", "quad", "lissajous");
+  m_shader_manager.addProgram("scope", "quad", "scope");
+  m_shader_manager.addProgram("vectorscope", "vectorscope", "vectorscope");
   auto bg = std::make_unique<BackgroundComponent>(*this, "bg");
   auto lissajous = std::make_unique<LissajousComponent>(*this, "lissajous");
+  auto vectorscope =
+      std::make_unique<VectorscopeComponent>(*this, "vectorscope");
   auto scope_x = std::make_unique<ScopeComponent>(*this, "scope", 0);
   auto scope_y = std::make_unique<ScopeComponent>(*this, "scope", 1);
   std::string_view fmt_hz = "{: >7.1f}{}";
@@ -53,10 +74,16 @@ void GlynthEditor::newOpenGLContextCreated() {
 
   juce::MessageManager::Lock lock;
   lock.enter();
+  // Left over from a previous context, with their GL objects already deleted
+  m_shader_components.clear();
   addAndMakeVisible(bg.get());
   bg->setBounds(getLocalBounds());
   addAndMakeVisible(lissajous.get());
   lissajous->setBounds(66, 146, 708, 125);
+  // Drawn over the preview, but clicks go through to focus it
+  addAndMakeVisible(vectorscope.get());
+  vectorscope->setInterceptsMouseClicks(false, false);
+  vectorscope->setBounds(lissajous->getBounds());
   addAndMakeVisible(scope_x.get());
   scope_x->setBounds(50 + 16 + 8, 50 + 16, 336, 64);
   addAndMakeVisible(scope_y.get());
@@ -69,95 +96,164 @@ void GlynthEditor::newOpenGLContextCreated() {
     int y_offset = (h + 8) * (static_cast<int>(i) / ncols);
     params[i]->setBounds(x + x_offset, y + y_offset, w, h);
   }
+#ifdef GLYNTH_LOAD_METER
+  auto load_meter = std::make_unique<LoadMeterComponent>(*this, "char");
+  addAndMakeVisible(load_meter.get());
+  load_meter->setBounds(8, 8, 320, load_meter->getHeight());
+#endif
   lock.exit();
 
   m_shader_components.push_back(std::move(bg));
   m_shader_components.push_back(std::move(lissajous));
+  m_shader_components.push_back(std::move(vectorscope));
   m_shader_components.push_back(std::move(scope_x));
   m_shader_components.push_back(std::move(scope_y));
   for (auto& param : params) {
     m_shader_components.push_back(std::move(param));
   }
+#ifdef GLYNTH_LOAD_METER
+  // Last so that it's drawn on top
+  m_shader_components.push_back(std::move(load_meter));
+#endif
+  m_components_ready = true;
+  requestRepaint();
 }
 
 void GlynthEditor::renderOpenGL() {
+  GLYNTH_TRACE_THREAD("OpenGL");
+  GLYNTH_TRACE_SCOPE("renderOpenGL");
   m_shader_manager.tryUpdateDirty();
+  m_font_manager.uploadReady();
 
   using namespace juce::gl;
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  juce::OpenGLHelpers::clear(juce::Colours::black);
+  updateStaticLayer();
+  // The layer is opaque, so it replaces the previous frame entirely
+  glDisable(GL_BLEND);
+  m_layer_component->setTexture(m_static_layer.getTextureID());
+  m_layer_component->renderOpenGL();
+  glEnable(GL_BLEND);
   for (auto& component : m_shader_components) {
     component->renderOpenGL();
   }
+  m_quad_batch->draw();
+  // Text goes on top of everything, all in one draw
+  m_text_batch->draw(m_font_manager.getAtlasTexture());
+}
+
+void GlynthEditor::updateStaticLayer() {
+  GLYNTH_TRACE_SCOPE("GlynthEditor::updateStaticLayer");
+  auto scale = m_context.getRenderingScale();
+  int width = juce::roundToInt(scale * getWidth());
+  int height = juce::roundToInt(scale * getHeight());
+  bool resized = m_static_layer.getWidth() != width ||
+                 m_static_layer.getHeight() != height;
+  auto glyph_generation = m_font_manager.getGeneration();
+  bool stale = resized || glyph_generation != m_static_glyph_generation;
+#ifdef GLYNTH_HSR
+  // Shaders may have been reloaded
+  stale = true;
+#endif
+  if (!stale) {
+    return;
+  }
+  if (resized && !m_static_layer.initialise(m_context, width, height)) {
+    fmt::println(Logger::file, "Unable to create the static layer");
+    return;
+  }
+  using namespace juce::gl;
+  m_static_layer.makeCurrentRenderingTarget();
+  juce::OpenGLHelpers::clear(juce::Colours::black);
+  for (auto& component : m_shader_components) {
+    component->renderStatic();
+  }
+  m_quad_batch->draw();
+  m_text_batch->draw(m_font_manager.getAtlasTexture());
+  m_static_layer.releaseAsRenderingTarget();
+  glViewport(0, 0, width, height);
+  m_static_glyph_generation = glyph_generation;
+}
+
+void GlynthEditor::openGLContextClosing() {
+  // Components are destroyed on the message thread, which may be blocked in
+  // detach() waiting for this callback, so only their GL objects go here
+  m_components_ready = false;
+  for (auto& component : m_shader_components) {
+    component->openGLContextClosing();
+  }
+  // Not on screen, so it's safe to destroy here
+  m_layer_component.reset();
+  m_text_batch.reset();
+  m_quad_batch.reset();
+  m_static_layer.release();
+  m_font_manager.releaseAtlas();
 }
 
-void GlynthEditor::openGLContextClosing() {}
+void GlynthEditor::timerCallback() {
+  bool needs_frame = m_repaint_requested.exchange(false);
+#ifdef GLYNTH_HSR
+  // Shader edits should show up without having to interact
+  needs_frame = true;
+#endif
+  // Glyphs still rendering will need uploading and laying out
+  needs_frame = needs_frame || m_font_manager.isRendering();
+  if (!needs_frame && m_components_ready) {
+    needs_frame = std::any_of(
+        m_shader_components.begin(), m_shader_components.end(),
+        [](const auto& component) { return component->needsFrame(); });
+  }
+  if (needs_frame) {
+    m_context.triggerRepaint();
+  }
+}
 
 ShaderComponent::ShaderComponent(GlynthEditor& editor_ref,
                                  const std::string& program_id)
     : m_editor_ref(editor_ref), m_processor_ref(editor_ref.m_processor_ref),
       m_shader_manager(editor_ref.m_shader_manager),
-      m_font_manager(editor_ref.m_font_manager), m_program_id(program_id) {}
+      m_font_manager(editor_ref.m_font_manager),
+      m_quad_batch(*editor_ref.m_quad_batch),
+      m_text_batch(*editor_ref.m_text_batch), m_program_id(program_id) {}
+
+float ShaderComponent::getRenderingScale() const {
+  return static_cast<float>(m_editor_ref.m_context.getRenderingScale());
+}
 
 BackgroundComponent::BackgroundComponent(GlynthEditor& editor_ref,
                                          const std::string& program_id)
-    : ShaderComponent(editor_ref, program_id) {
-  using namespace juce::gl;
-  glGenBuffers(1, &m_vbo);
-  glGenVertexArrays(1, &m_vao);
-  glBindVertexArray(m_vao);
-  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-  std::array<GLfloat, 6> vertices = {-1, -1, 3, -1, -1, 3};
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices.data(),
-               GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
-  glEnableVertexAttribArray(0);
-  glBindVertexArray(0);
-}
+    : ShaderComponent(editor_ref, program_id) {}
 
-BackgroundComponent::~BackgroundComponent() {
-  using namespace juce::gl;
-  glDeleteBuffers(1, &m_vbo);
-  glDeleteVertexArrays(1, &m_vao);
+void BackgroundComponent::renderStatic() { drawFullscreen(); }
+
+void BackgroundComponent::drawFullscreen() {
+  // The vertex shader ignores the rect and covers the viewport
+  m_quad_batch.drawOne(m_program_id);
 }
 
-void BackgroundComponent::renderOpenGL() {
+LayerComponent::LayerComponent(GlynthEditor& editor_ref,
+                               const std::string& program_id)
+    : BackgroundComponent(editor_ref, program_id) {}
+
+void LayerComponent::renderOpenGL() {
   using namespace juce::gl;
-  glBindVertexArray(m_vao); // Also binds m_ebo
-  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-  m_shader_manager.useProgram(m_program_id);
-  glDrawArrays(GL_TRIANGLES, 0, 3);
-  glBindVertexArray(0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  drawFullscreen();
 }
 
 RectComponent::RectComponent(GlynthEditor& editor_ref,
                              const std::string& program_id)
-    : ShaderComponent(editor_ref, program_id) {
-  using namespace juce::gl;
-  glGenBuffers(1, &m_vbo);
-  glGenBuffers(1, &m_ebo);
-  glGenVertexArrays(1, &m_vao);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-  std::array indices = {0u, 1u, 2u, 0u, 2u, 3u};
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices.data(),
-               GL_STATIC_DRAW);
-}
+    : ShaderComponent(editor_ref, program_id),
+      m_projection_uniform(m_shader_manager.getUniform<glm::mat4>(
+          program_id, "u_projection")) {}
 
-RectComponent::~RectComponent() {
-  using namespace juce::gl;
-  glDeleteBuffers(1, &m_vbo);
-  glDeleteBuffers(1, &m_ebo);
-  glDeleteVertexArrays(1, &m_vao);
+void RectComponent::renderOpenGL() {
+  m_quad_batch.add(m_program_id, {.rect = m_rect});
 }
 
-void RectComponent::renderOpenGL() {
-  using namespace juce::gl;
-  glBindVertexArray(m_vao); // Also binds m_ebo
-  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-  m_shader_manager.useProgram(m_program_id);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-  glBindVertexArray(0);
+void RectComponent::drawNow() {
+  m_quad_batch.drawOne(m_program_id, {.rect = m_rect});
 }
 
 void RectComponent::paint(juce::Graphics& g) {
@@ -166,10 +262,6 @@ void RectComponent::paint(juce::Graphics& g) {
 }
 
 void RectComponent::resized() {
-  using namespace juce::gl;
-  glBindVertexArray(m_vao);
-  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
   auto bounds = getBounds();
   auto width = bounds.getWidth();
   auto height = bounds.getHeight();
@@ -182,27 +274,11 @@ void RectComponent::resized() {
   float y = window_h - static_cast<float>(bounds.getY() + parent_y + height);
   float w = static_cast<float>(width);
   float h = static_cast<float>(height);
-  std::array<RectVertex, 4> vertices = {
-      RectVertex{.pos = glm::vec2(x, y), .uv = glm::vec2(0, 0)},
-      RectVertex{.pos = glm::vec2(x, y + h), .uv = glm::vec2(0, 1)},
-      RectVertex{.pos = glm::vec2(x + w, y + h), .uv = glm::vec2(1, 1)},
-      RectVertex{.pos = glm::vec2(x + w, y), .uv = glm::vec2(1, 0)}};
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices.data(),
-               GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex), nullptr);
-  glVertexAttribPointer(
-      1, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex),
-      reinterpret_cast<const void*>(offsetof(RectVertex, uv)));
-  glEnableVertexAttribArray(0);
-  glEnableVertexAttribArray(1);
-  glBindVertexArray(0);
+  m_rect = glm::vec4(x, y, w, h);
   // Must use shader before setting uniforms
   m_shader_manager.useProgram(m_program_id);
-  auto resolution = glm::vec2(width, height);
-  m_shader_manager.setUniform(m_program_id, "u_resolution", resolution);
   // Add projection matrix as uniform by getting parent (editor) bounds
-  glm::mat4 projection = glm::ortho(0.0f, window_w, 0.0f, window_h);
-  m_shader_manager.setUniform(m_program_id, "u_projection", projection);
+  m_projection_uniform.set(glm::ortho(0.0f, window_w, 0.0f, window_h));
 }
 
 KnobComponent::KnobComponent(GlynthEditor& editor_ref,
@@ -214,11 +290,9 @@ KnobComponent::KnobComponent(GlynthEditor& editor_ref,
 }
 
 void KnobComponent::renderOpenGL() {
-  // Uniforms can only be updated from the OpenGL thread
+  // Every knob is drawn in one call, with its value in the instance data
   float value = m_range.convertTo0to1(m_param);
-  m_shader_manager.useProgram(m_program_id);
-  m_shader_manager.setUniform(m_program_id, "u_value", value);
-  RectComponent::renderOpenGL();
+  m_quad_batch.add(m_program_id, {.rect = m_rect, .value = value});
 }
 
 void KnobComponent::mouseDown(const juce::MouseEvent& e) {
@@ -243,47 +317,22 @@ void KnobComponent::mouseUp(const juce::MouseEvent&) {
 TextComponent::TextComponent(GlynthEditor& editor_ref,
                              const std::string& program_id,
                              std::string_view text)
-    : ShaderComponent(editor_ref, program_id), m_text(text) {
-  // Initialize buffers
-  using namespace juce::gl;
-  glGenVertexArrays(1, &m_vao);
-  glGenBuffers(1, &m_vbo);
-  glGenBuffers(1, &m_ebo);
-  glBindVertexArray(m_vao);
-  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-  // Reserve enough buffer space for an indexed quad
-  glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(RectVertex), nullptr,
-               GL_DYNAMIC_DRAW);
-  std::array indices = {0u, 1u, 2u, 0u, 2u, 3u};
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices.data(),
-               GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex), nullptr);
-  glVertexAttribPointer(
-      1, 2, GL_FLOAT, GL_FALSE, sizeof(RectVertex),
-      reinterpret_cast<const void*>(offsetof(RectVertex, uv)));
-  glEnableVertexAttribArray(0);
-  glEnableVertexAttribArray(1);
-  // Unbind buffers
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
-}
+    : ShaderComponent(editor_ref, program_id), m_text(text),
+      m_projection_uniform(m_shader_manager.getUniform<glm::mat4>(
+          program_id, "u_projection")) {}
 
-TextComponent::~TextComponent() {
-  using namespace juce::gl;
-  glDeleteBuffers(1, &m_vbo);
-  glDeleteVertexArrays(1, &m_vao);
+void TextComponent::renderOpenGL() {
+  bool glyphs_added = m_font_manager.getGeneration() != m_layout_generation;
+  if (m_layout_dirty.exchange(false) || (m_missing_glyphs && glyphs_added)) {
+    layout();
+  }
+  m_text_batch.add(m_quads);
 }
 
-void TextComponent::renderOpenGL() {
-  using namespace juce::gl;
-  glBindVertexArray(m_vao);
-  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-  m_shader_manager.useProgram(m_program_id);
-  glActiveTexture(GL_TEXTURE0);
-  // TODO make more efficient by storing all the geometry on the GPU and
-  // activating certain indices where appropriate. This is currently the
-  // performance hotspot of the application!
+void TextComponent::layout() {
+  m_quads.clear();
+  m_missing_glyphs = false;
+  m_layout_generation = m_font_manager.getGeneration();
   auto bounds = getBounds();
   auto* parent = getParentComponent();
   int parent_x = parent ? parent->getX() : 0;
@@ -293,26 +342,38 @@ void TextComponent::renderOpenGL() {
   // origin is where to start drawing text
   float origin_x = static_cast<float>(bounds.getX() + parent_x);
   float origin_y = w_h - static_cast<float>(bounds.getY() + parent_y) - height;
+  // Glyph metrics are at the atlas's reference height
+  float scale = static_cast<float>(m_pixel_height) /
+                static_cast<float>(FontManager::s_sdf_pixel_height);
   for (char c_raw : m_text) {
-    auto& c = m_font_manager.getCharacter(m_face_name, c_raw, m_pixel_height);
-    float x = origin_x + c.bearing.x;
-    float y = origin_y - (c.size.y - c.bearing.y);
-    float w = c.size.x;
-    float h = c.size.y;
-    std::array<RectVertex, 4> vertices = {
-        RectVertex{.pos = glm::vec2(x, y), .uv = glm::vec2(0, 0)},
-        RectVertex{.pos = glm::vec2(x, y + h), .uv = glm::vec2(0, 1)},
-        RectVertex{.pos = glm::vec2(x + w, y + h), .uv = glm::vec2(1, 1)},
-        RectVertex{.pos = glm::vec2(x + w, y), .uv = glm::vec2(1, 0)},
-    };
-    glBindTexture(GL_TEXTURE_2D, c.texture);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices.data());
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-    origin_x += c.advance;
-  }
-  // Unbind buffers
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+    auto* character = m_font_manager.getCharacter(m_face_name, c_raw);
+    if (character == nullptr) {
+      // Keep going, so every missing glyph is requested at once
+      m_missing_glyphs = true;
+      continue;
+    }
+    auto& c = *character;
+    float x = origin_x + c.bearing.x * scale;
+    float y = origin_y - (c.size.y - c.bearing.y) * scale;
+    float w = c.size.x * scale;
+    float h = c.size.y * scale;
+    // Bitmaps are stored top row first, so the bottom of the quad samples
+    // uv_max.y
+    m_quads.insert(
+        m_quads.end(),
+        {
+            {.pos = glm::vec2(x, y), .uv = glm::vec2(c.uv_min.x, c.uv_max.y)},
+            {.pos = glm::vec2(x, y + h), .uv = c.uv_min},
+            {.pos = glm::vec2(x + w, y + h),
+             .uv = glm::vec2(c.uv_max.x, c.uv_min.y)},
+            {.pos = glm::vec2(x + w, y), .uv = c.uv_max},
+        });
+    origin_x += c.advance * scale;
+  }
+  if (m_missing_glyphs) {
+    // Spacing would be wrong, so wait until the whole string is ready
+    m_quads.clear();
+  }
 }
 
 void TextComponent::paint(juce::Graphics& g) {
@@ -321,18 +382,26 @@ void TextComponent::paint(juce::Graphics& g) {
 }
 
 void TextComponent::resized() {
+  m_layout_dirty = true;
   // Add projection matrix as uniform by getting parent (editor) bounds
   float w = static_cast<float>(m_editor_ref.getWidth());
   float h = static_cast<float>(m_editor_ref.getHeight());
   m_shader_manager.useProgram(m_program_id);
-  glm::mat4 projection = glm::ortho(0.0f, w, 0.0f, h);
-  m_shader_manager.setUniform(m_program_id, "u_projection", projection);
+  m_projection_uniform.set(glm::ortho(0.0f, w, 0.0f, h));
 }
 
 void TextComponent::setFontFace(std::string_view face_name,
                                 FT_UInt pixel_height) {
   m_face_name = std::string(face_name);
   m_pixel_height = pixel_height;
+  m_layout_dirty = true;
+}
+
+void TextComponent::setText(std::string_view text) {
+  if (text != m_text) {
+    m_text = text;
+    m_layout_dirty = true;
+  }
 }
 
 NumberComponent::NumberComponent(GlynthEditor& editor_ref,
@@ -343,8 +412,12 @@ NumberComponent::NumberComponent(GlynthEditor& editor_ref,
       m_param(m_processor_ref.getParamById(param_id)), m_format(format) {}
 
 void NumberComponent::renderOpenGL() {
-  std::string suffix = m_param.getLabel().toStdString();
-  m_text = fmt::format(fmt::runtime(m_format), m_param.get(), suffix);
+  float value = m_param.get();
+  if (!m_value.has_value() || !juce::exactlyEqual(*m_value, value)) {
+    std::string suffix = m_param.getLabel().toStdString();
+    setText(fmt::format(fmt::runtime(m_format), value, suffix));
+    m_value = value;
+  }
   TextComponent::renderOpenGL();
 }
 
@@ -375,9 +448,13 @@ ParameterComponent::ParameterComponent(GlynthEditor& editor_ref,
 }
 
 void ParameterComponent::renderOpenGL() {
-  RectComponent::renderOpenGL();
   m_knob.renderOpenGL();
   m_number.renderOpenGL();
+}
+
+void ParameterComponent::renderStatic() {
+  RectComponent::renderOpenGL();
+  // Added to the text batch, which is drawn into the layer
   m_label.renderOpenGL();
 }
 
@@ -408,10 +485,22 @@ void ParameterComponent::mouseDoubleClick(const juce::MouseEvent&) {
 }
 
 LissajousComponent::LissajousComponent(GlynthEditor& editor_ref,
-                                       const std::string& program_id,
-                                       size_t num_samples)
-    : RectComponent(editor_ref, program_id), m_num_samples(num_samples) {
-  m_samples.resize(m_num_samples);
+                                       const std::string& program_id)
+    : RectComponent(editor_ref, program_id),
+      m_outline_reader(m_processor_ref.getOutlineSnapshots()),
+      m_time_uniform(m_shader_manager.getUniform<float>(program_id, "u_time")),
+      m_has_outline_uniform(
+          m_shader_manager.getUniform<bool>(program_id, "u_has_outline")),
+      m_glyph_corner_uniform(m_shader_manager.getUniform<glm::vec2>(
+          program_id, "u_outline_glyph_corner")),
+      m_glyph_size_uniform(m_shader_manager.getUniform<glm::vec2>(
+          program_id, "u_outline_glyph_size")),
+      m_cell_size_uniform(
+          m_shader_manager.getUniform<float>(program_id, "u_cell_size")),
+      m_cells_uniform(m_shader_manager.getUniform<int>(program_id, "u_cells")),
+      m_segments_uniform(
+          m_shader_manager.getUniform<int>(program_id, "u_segments")) {
+  m_samples.resize(OutlineBuilder::s_num_preview_samples);
   // Needed in order to capture keyboard events
   setWantsKeyboardFocus(true);
   setMouseClickGrabsKeyboardFocus(true);
@@ -432,6 +521,20 @@ LissajousComponent::LissajousComponent(GlynthEditor& editor_ref,
   glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  // The grid, filled in once the outline is laid out
+  glGenTextures(1, &m_cell_texture);
+  glBindTexture(GL_TEXTURE_2D, m_cell_texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glGenBuffers(1, &m_segment_buffer);
+  glGenTextures(1, &m_segment_texture);
+  glBindTexture(GL_TEXTURE_BUFFER, m_segment_texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_segment_buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  m_shader_manager.useProgram(m_program_id);
+  m_cell_size_uniform.set(s_cell_size);
+  m_cells_uniform.set(1);
+  m_segments_uniform.set(2);
   // Get content from the processor's state
   m_content = m_processor_ref.getOutlineText();
 }
@@ -440,23 +543,23 @@ LissajousComponent::~LissajousComponent() {
   m_editor_ref.removeMouseListener(this);
 }
 
+void LissajousComponent::openGLContextClosing() {
+  using namespace juce::gl;
+  glDeleteTextures(1, &m_texture);
+  glDeleteTextures(1, &m_cell_texture);
+  glDeleteTextures(1, &m_segment_texture);
+  glDeleteBuffers(1, &m_segment_buffer);
+}
+
 void LissajousComponent::paint(juce::Graphics& g) {
   g.setColour(juce::Colours::red);
   // g.drawRect(getLocalBounds());
 }
 
 void LissajousComponent::resized() {
-  // This must be in the resized method instead of the constructor because these
-  // methods depend on the bounds of this component, which aren't known then
-  using namespace juce::gl;
-  m_shader_manager.useProgram(m_program_id);
-  onContentChanged();
-  // m_processor_ref.updateOutline(m_outline);
-  m_shader_manager.setUniform(m_program_id, "u_has_outline", m_content != "");
-  m_shader_manager.setUniform(m_program_id, "u_outline_glyph_corner",
-                              m_outline_glyph_corner);
-  m_shader_manager.setUniform(m_program_id, "u_outline_glyph_size",
-                              m_outline_glyph_size);
+  // Layout depends on the bounds of this component, which aren't known in the
+  // constructor
+  m_dirty = true;
   RectComponent::resized();
 }
 
@@ -472,11 +575,14 @@ void LissajousComponent::mouseDown(const juce::MouseEvent& e) {
 void LissajousComponent::focusGained(FocusChangeType) {
   m_focused = true;
   m_last_change_time = std::chrono::high_resolution_clock::now();
+  m_editor_ref.requestRepaint();
 }
 
 void LissajousComponent::focusLost(FocusChangeType) {
   // Consider only changing the text here instead of every character
   m_focused = false;
+  // Clears the cursor
+  m_editor_ref.requestRepaint();
 }
 
 bool LissajousComponent::keyPressed(const juce::KeyPress& key) {
@@ -514,62 +620,60 @@ bool LissajousComponent::keyPressed(const juce::KeyPress& key) {
 
 void LissajousComponent::renderOpenGL() {
   m_shader_manager.useProgram(m_program_id);
-  m_shader_manager.setUniform(m_program_id, "u_time", getTimeUniform());
+  m_time_uniform.set(getTimeUniform());
   using namespace juce::gl;
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_1D, m_texture);
-  if (m_dirty) {
-    if (m_content == "") {
-      m_shader_manager.setUniform(m_program_id, "u_has_outline", false);
-    } else {
-      if (m_samples.size() > 0) {
-        // Size is zero when sampling a space since that has no segments
-        glTexSubImage1D(GL_TEXTURE_1D, 0, 0,
-                        static_cast<GLsizei>(m_samples.size()), GL_RG, GL_FLOAT,
-                        m_samples.data());
-      } else {
-        std::vector<glm::vec2> zeros(m_num_samples);
-        glTexSubImage1D(GL_TEXTURE_1D, 0, 0, static_cast<GLsizei>(zeros.size()),
-                        GL_RG, GL_FLOAT, zeros.data());
-      }
-      m_shader_manager.setUniform(m_program_id, "u_has_outline", true);
-    }
-    m_shader_manager.setUniform(m_program_id, "u_outline_glyph_corner",
-                                m_outline_glyph_corner);
-    m_shader_manager.setUniform(m_program_id, "u_outline_glyph_size",
-                                m_outline_glyph_size);
+  // Before acquiring, so a snapshot published in between gets another frame
+  m_num_published_drawn =
+      m_processor_ref.getOutlineSnapshots().getNumPublished();
+  auto* outline = m_outline_reader.acquire();
+  if (outline != nullptr &&
+      (m_dirty || outline->version != m_outline_version)) {
+    layoutOutline(*outline);
+    m_outline_version = outline->version;
     m_dirty = false;
   }
-  RectComponent::renderOpenGL();
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, m_cell_texture);
+  glActiveTexture(GL_TEXTURE2);
+  glBindTexture(GL_TEXTURE_BUFFER, m_segment_texture);
+  glActiveTexture(GL_TEXTURE0);
+  drawNow();
+}
+
+bool LissajousComponent::needsFrame() const {
+  auto num_published = m_processor_ref.getOutlineSnapshots().getNumPublished();
+  return m_focused || m_dirty || num_published != m_num_published_drawn;
 }
 
 void LissajousComponent::onContentChanged() {
-  fmt::println(Logger::file, R"(m_content = "{}")", m_content);
-  auto face = m_processor_ref.getOutlineFace();
+  GLYNTH_TRACE_SCOPE("LissajousComponent::onContentChanged");
+  // Built on a worker thread, and picked up in renderOpenGL when ready
+  m_processor_ref.setOutlineText(m_content);
+  // Stay solid during changes and only start blinking afterward
+  m_last_change_time = std::chrono::high_resolution_clock::now();
+  m_editor_ref.requestRepaint();
+}
+
+void LissajousComponent::layoutOutline(const OutlineSnapshot& snapshot) {
+  auto& data = *snapshot.data;
   auto bounds = getBounds();
   auto w_bounds = static_cast<float>(bounds.getWidth());
   auto h_bounds = static_cast<float>(bounds.getHeight());
-  float h_face = static_cast<float>(face->size->metrics.height) / 64;
+  float h_face = data.face_height;
 
-  if (m_content == "") {
+  if (snapshot.text == "") {
     // Use the width of 'x' when there is no character to show
-    if (auto err = FT_Load_Char(face, 'x', FT_LOAD_DEFAULT)) {
-      throw FreetypeError(FT_Error_String(err));
-    }
     float scale = h_bounds / h_face;
-    auto& glyph = *face->glyph;
-    float width = scale * static_cast<float>(glyph.metrics.width) / 64;
+    float width = scale * data.last_glyph_width;
     m_outline_glyph_size.x = width;
     m_outline_glyph_size.y = h_bounds;
     m_outline_glyph_corner.x = (w_bounds - width) / 2;
     m_outline_glyph_corner.y = 0;
+    m_has_outline_uniform.set(false);
   } else {
-    // Non-empty content gets sent over to replace outline
-    m_processor_ref.setOutlineText(m_content);
-    auto& outline = m_processor_ref.getOutline();
-    m_samples = outline.sample(m_num_samples);
-    auto& bbox = outline.bbox();
-    float descender = static_cast<float>(face->size->metrics.descender) / 64;
+    auto& bbox = data.bbox;
     float w_outline = h_bounds / h_face * bbox.width();
     float h_outline = h_bounds;
     if (w_outline > w_bounds) {
@@ -580,31 +684,94 @@ void LissajousComponent::onContentChanged() {
     // Offsets trequired to center the text in the component
     float offset_x = (w_bounds - w_outline) / 2;
     float offset_y = (h_bounds - h_outline) / 2;
-    // Shift and rescale samples so they fit inside component
-    for (auto& sample : m_samples) {
+    // Size is zero when sampling a space since that has no segments
+    std::fill(m_samples.begin(), m_samples.end(), glm::vec2(0));
+    for (size_t i = 0; i < data.samples.size(); i++) {
+      auto sample = data.samples[i];
       // Normalize sample coordinates to 0 -> 1
       sample.x = (sample.x - bbox.min.x) / bbox.width();
-      sample.y = (sample.y - descender) / h_face;
+      sample.y = (sample.y - data.descender) / h_face;
       // Rescale to component height and match old aspect ratio
       sample.x = sample.x * w_outline + offset_x;
       sample.y = sample.y * h_outline + offset_y;
+      m_samples[i] = sample;
     }
     // Get glyph dimensions for last character in outline
-    auto char_code = static_cast<FT_ULong>(m_content.back());
-    if (auto err = FT_Load_Char(face, char_code, FT_LOAD_DEFAULT)) {
-      throw FreetypeError(FT_Error_String(err));
-    }
-    auto& glyph = *face->glyph;
     float scale = h_outline / h_face;
-    float width = scale * static_cast<float>(glyph.metrics.width) / 64;
+    float width = scale * data.last_glyph_width;
     m_outline_glyph_size.x = width;
     m_outline_glyph_size.y = h_outline;
     m_outline_glyph_corner.x = w_outline + offset_x - width;
     m_outline_glyph_corner.y = offset_y;
+    using namespace juce::gl;
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, static_cast<GLsizei>(m_samples.size()),
+                    GL_RG, GL_FLOAT, m_samples.data());
+    // Nothing can be drawn until the component has an area
+    m_has_outline_uniform.set(buildGrid());
   }
-  // Stay solid during changes and only start blinking afterward
-  m_last_change_time = std::chrono::high_resolution_clock::now();
-  m_dirty = true;
+  m_glyph_corner_uniform.set(m_outline_glyph_corner);
+  m_glyph_size_uniform.set(m_outline_glyph_size);
+}
+
+bool LissajousComponent::buildGrid() {
+  GLYNTH_TRACE_SCOPE("LissajousComponent::buildGrid");
+  auto num_x = static_cast<size_t>(
+      std::ceil(static_cast<float>(getWidth()) / s_cell_size));
+  auto num_y = static_cast<size_t>(
+      std::ceil(static_cast<float>(getHeight()) / s_cell_size));
+  if (num_x == 0 || num_y == 0) {
+    return false;
+  }
+  // Half the line width plus the smoothing, so every pixel a segment
+  // shades is in a cell that lists it
+  constexpr float reach = 1.5f;
+  auto for_each_cell = [&](auto&& fn) {
+    for (size_t i = 0; i + 1 < m_samples.size(); i++) {
+      auto a = m_samples[i];
+      auto b = m_samples[i + 1];
+      if (a == b) {
+        // Zero length, like the padding when the text has no segments
+        continue;
+      }
+      auto lo = glm::max(glm::min(a, b) - reach, 0.0f) / s_cell_size;
+      auto hi = glm::max(glm::max(a, b) + reach, 0.0f) / s_cell_size;
+      auto x1 = std::min(static_cast<size_t>(hi.x), num_x - 1);
+      auto y1 = std::min(static_cast<size_t>(hi.y), num_y - 1);
+      for (auto y = static_cast<size_t>(lo.y); y <= y1; y++) {
+        for (auto x = static_cast<size_t>(lo.x); x <= x1; x++) {
+          fn(y * num_x + x, i);
+        }
+      }
+    }
+  };
+  // Count, then lay the lists out back to back and fill them
+  m_cells.assign(num_x * num_y, glm::uvec2(0));
+  for_each_cell([&](size_t cell, size_t) { m_cells[cell].y++; });
+  GLuint first = 0;
+  for (auto& cell : m_cells) {
+    cell.x = first;
+    first += std::exchange(cell.y, 0);
+  }
+  m_cell_segments.resize(first);
+  for_each_cell([&](size_t cell, size_t segment) {
+    auto& range = m_cells[cell];
+    m_cell_segments[range.x + range.y++] = static_cast<GLuint>(segment);
+  });
+
+  using namespace juce::gl;
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, m_cell_texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, static_cast<GLsizei>(num_x),
+               static_cast<GLsizei>(num_y), 0, GL_RG_INTEGER, GL_UNSIGNED_INT,
+               m_cells.data());
+  glBindBuffer(GL_TEXTURE_BUFFER, m_segment_buffer);
+  glBufferData(
+      GL_TEXTURE_BUFFER,
+      static_cast<GLsizeiptr>(m_cell_segments.size() * sizeof(GLuint)),
+      m_cell_segments.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  glActiveTexture(GL_TEXTURE0);
+  return true;
 }
 
 float LissajousComponent::getTimeUniform() {
@@ -619,6 +786,94 @@ float LissajousComponent::getTimeUniform() {
   }
 }
 
+VectorscopeComponent::VectorscopeComponent(GlynthEditor& editor_ref,
+                                           const std::string& program_id)
+    : RectComponent(editor_ref, program_id),
+      m_tap(m_processor_ref.getXYTap()),
+      m_corner_uniform(
+          m_shader_manager.getUniform<glm::vec2>(program_id, "u_corner")),
+      m_size_uniform(
+          m_shader_manager.getUniform<glm::vec2>(program_id, "u_size")),
+      m_head_uniform(m_shader_manager.getUniform<int>(program_id, "u_head")),
+      m_capacity_uniform(
+          m_shader_manager.getUniform<int>(program_id, "u_capacity")),
+      m_persistence_uniform(
+          m_shader_manager.getUniform<float>(program_id, "u_persistence")),
+      m_idle_uniform(m_shader_manager.getUniform<float>(program_id, "u_idle")),
+      m_last_frames_time(std::chrono::steady_clock::time_point{}) {
+  m_frames.reserve(s_capacity);
+  using namespace juce::gl;
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_vbo);
+  glBindVertexArray(m_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  // Allocated once, then only ever updated in place
+  glBufferData(GL_ARRAY_BUFFER,
+               static_cast<GLsizeiptr>(s_capacity * sizeof(glm::vec2)),
+               nullptr, GL_STREAM_DRAW);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr);
+  glEnableVertexAttribArray(0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  m_shader_manager.useProgram(m_program_id);
+  m_capacity_uniform.set(static_cast<int>(s_capacity));
+}
+
+void VectorscopeComponent::openGLContextClosing() {
+  using namespace juce::gl;
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void VectorscopeComponent::renderOpenGL() {
+  GLYNTH_TRACE_SCOPE("VectorscopeComponent::renderOpenGL");
+  auto now = std::chrono::steady_clock::now();
+  m_frames.clear();
+  m_tap.drain(m_frames, s_capacity);
+  using namespace juce::gl;
+  glBindVertexArray(m_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  if (!m_frames.empty()) {
+    // Wraps around like the ring it was drained from
+    size_t first = std::min(m_frames.size(), s_capacity - m_head);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(m_head * sizeof(glm::vec2)),
+                    static_cast<GLsizeiptr>(first * sizeof(glm::vec2)),
+                    m_frames.data());
+    glBufferSubData(
+        GL_ARRAY_BUFFER, 0,
+        static_cast<GLsizeiptr>((m_frames.size() - first) * sizeof(glm::vec2)),
+        m_frames.data() + first);
+    m_head = (m_head + m_frames.size()) % s_capacity;
+    m_num_points = std::min(m_num_points + m_frames.size(), s_capacity);
+    m_last_frames_time = now;
+  }
+  // Keeps fading while no new frames arrive, like when playback stops
+  std::chrono::duration<float> idle = now - m_last_frames_time.load();
+  if (m_num_points > 0 && idle.count() < s_fade_time) {
+    auto sample_rate = static_cast<float>(m_tap.getSampleRate());
+    m_shader_manager.useProgram(m_program_id);
+    m_corner_uniform.set(glm::vec2(m_rect.x, m_rect.y));
+    m_size_uniform.set(glm::vec2(m_rect.z, m_rect.w));
+    m_head_uniform.set(static_cast<int>(m_head));
+    m_persistence_uniform.set(s_persistence * sample_rate);
+    m_idle_uniform.set(idle.count() * sample_rate);
+    // Overlapping points add up, so dense parts of the trace glow
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    // Before the ring fills, the valid points are the first m_num_points
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(m_num_points));
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+bool VectorscopeComponent::needsFrame() const {
+  std::chrono::duration<float> idle =
+      std::chrono::steady_clock::now() - m_last_frames_time.load();
+  return m_tap.hasNewFrames() || idle.count() < s_fade_time;
+}
+
 ScopeComponent::ScopeComponent(GlynthEditor& editor_ref,
                                const std::string& program_id, int channel)
     : RectComponent(editor_ref, program_id),
@@ -627,7 +882,6 @@ ScopeComponent::ScopeComponent(GlynthEditor& editor_ref,
   glGenTextures(1, &m_texture);
   glBindTexture(GL_TEXTURE_1D, m_texture);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-  // TODO draw a default texture
   glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -637,22 +891,69 @@ void ScopeComponent::renderOpenGL() {
   using namespace juce::gl;
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_1D, m_texture);
+  // One column per physical pixel, so the trace keeps its detail on HiDPI
+  // displays. The scale changes when the window moves between displays
+  auto num_columns = static_cast<size_t>(
+      juce::roundToInt(getRenderingScale() * static_cast<float>(getWidth())));
+  bool resized = m_dirty.exchange(false) || num_columns != m_columns.size();
+  if (resized) {
+    // Allocated once per size, so bursts only need a sub-image upload
+    m_columns.assign(num_columns, glm::vec2(0));
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RG32F,
+                 static_cast<GLsizei>(m_columns.size()), 0, GL_RG, GL_FLOAT,
+                 m_columns.data());
+  }
   // Non-null if there is a new value
-  if (auto&& buffer_opt = m_trigger_handler_ref.getBurstBuffer()) {
-    m_samples = std::move(buffer_opt.value());
-    // Rescale so -1 -> 1 fits within the vertical middle half
-    float height = static_cast<float>(getHeight());
-    for (auto& sample : m_samples) {
-      sample = (sample + 1) / 2 * height;
-    }
-    // Update texture data
-    glTexImage1D(GL_TEXTURE_1D, 0, GL_RED,
-                 static_cast<GLsizei>(m_samples.size()), 0, GL_RED, GL_FLOAT,
-                 m_samples.data());
-    m_dirty = false;
+  auto* burst = m_trigger_handler_ref.getBurstBuffer();
+  if (burst != nullptr) {
+    m_samples.assign(burst->begin(), burst->end());
+  }
+  if ((burst != nullptr || resized) && !m_columns.empty()) {
+    decimate();
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0,
+                    static_cast<GLsizei>(m_columns.size()), GL_RG, GL_FLOAT,
+                    m_columns.data());
   }
 
-  RectComponent::renderOpenGL();
+  drawNow();
+}
+
+void ScopeComponent::decimate() {
+  GLYNTH_TRACE_SCOPE("ScopeComponent::decimate");
+  float height = static_cast<float>(getHeight());
+  if (m_samples.size() < 2) {
+    // Nothing to trace yet, so show silence across the middle
+    std::fill(m_columns.begin(), m_columns.end(), glm::vec2(height / 2));
+    return;
+  }
+  size_t last_sample = m_samples.size() - 1;
+  auto samples_per_column = static_cast<float>(last_sample) /
+                            static_cast<float>(m_columns.size());
+  auto interpolate = [&](float t) {
+    t = std::min(t, static_cast<float>(last_sample));
+    auto i = std::min(static_cast<size_t>(t), last_sample - 1);
+    float frac = t - static_cast<float>(i);
+    return std::lerp(m_samples[i], m_samples[i + 1], frac);
+  };
+  for (size_t column = 0; column < m_columns.size(); column++) {
+    // Include the trace where it crosses both edges, so neighbouring
+    // columns overlap and the line stays connected at any zoom
+    float t0 = static_cast<float>(column) * samples_per_column;
+    float t1 = static_cast<float>(column + 1) * samples_per_column;
+    float y0 = interpolate(t0);
+    float y1 = interpolate(t1);
+    auto extent = juce::Range<float>::between(y0, y1);
+    auto first = static_cast<size_t>(std::ceil(t0));
+    auto last = std::min(static_cast<size_t>(t1), last_sample);
+    if (first <= last) {
+      // Vectorized by JUCE, and most of the work for long bursts
+      extent = extent.getUnionWith(juce::FloatVectorOperations::findMinAndMax(
+          m_samples.data() + first, static_cast<int>(last - first + 1)));
+    }
+    // Rescale so -1 -> 1 fits the height
+    m_columns[column] = glm::vec2(extent.getStart() + 1, extent.getEnd() + 1) /
+                        2.0f * height;
+  }
 }
 
 void ScopeComponent::paint(juce::Graphics& g) {
@@ -660,4 +961,71 @@ void ScopeComponent::paint(juce::Graphics& g) {
   // g.drawRect(getLocalBounds());
 }
 
-void ScopeComponent::resized() { RectComponent::resized(); }
+void ScopeComponent::resized() {
+  m_dirty = true;
+  RectComponent::resized();
+}
+
+bool ScopeComponent::needsFrame() const {
+  return m_trigger_handler_ref.hasNewBurst();
+}
+
+void ScopeComponent::openGLContextClosing() {
+  using namespace juce::gl;
+  glDeleteTextures(1, &m_texture);
+}
+
+#ifdef GLYNTH_LOAD_METER
+LoadMeterComponent::LoadMeterComponent(GlynthEditor& editor_ref,
+                                       const std::string& program_id)
+    : ShaderComponent(editor_ref, program_id),
+      m_load_meter(m_processor_ref.getLoadMeter()) {
+  // One line for the summary, one for the header, and one per stage
+  size_t num_lines = 2 + m_load_meter.getStats().stages.size();
+  juce::MessageManager::Lock lock;
+  lock.enter();
+  for (size_t i = 0; i < num_lines; i++) {
+    auto& line = m_lines.emplace_back(
+        std::make_unique<TextComponent>(editor_ref, program_id, ""));
+    line->setFontFace("SplineSansMono-Medium", 10);
+    addAndMakeVisible(line.get());
+  }
+  setSize(getWidth(), static_cast<int>(num_lines) * s_line_height);
+  lock.exit();
+  updateText();
+}
+
+void LoadMeterComponent::renderOpenGL() {
+  auto now = std::chrono::steady_clock::now();
+  if (now - m_last_update >= s_update_interval) {
+    updateText();
+    m_last_update = now;
+  }
+  for (auto& line : m_lines) {
+    line->renderOpenGL();
+  }
+}
+
+void LoadMeterComponent::resized() {
+  for (size_t i = 0; i < m_lines.size(); i++) {
+    int y = static_cast<int>(i) * s_line_height;
+    m_lines[i]->setBounds(0, y, getWidth(), s_line_height);
+    m_lines[i]->resized();
+  }
+}
+
+void LoadMeterComponent::updateText() {
+  auto stats = m_load_meter.getStats();
+  m_lines[0]->setText(fmt::format("{} blocks, {} missed ({:.2f} ms deadline)",
+                                  stats.blocks, stats.misses,
+                                  stats.deadline_ms));
+  m_lines[1]->setText(fmt::format("{:<12}{:>7}{:>7}{:>7}{:>7}", "stage", "mean",
+                                  "p99", "max", "miss"));
+  for (size_t i = 0; i < stats.stages.size(); i++) {
+    auto& stage = stats.stages[i];
+    m_lines[i + 2]->setText(fmt::format(
+        "{:<12}{:>6.1f}%{:>6.1f}%{:>6.1f}%{:>7}", stage.name, 100 * stage.mean,
+        100 * stage.p99, 100 * stage.max, stage.misses));
+  }
+}
+#endif
@@ -2,7 +2,9 @@
 
 #include "font_manager.h"
 #include "processor.h"
+#include "quad_batch.h"
 #include "shader_manager.h"
+#include "text_batch.h"
 
 #include <efsw/efsw.hpp>
 #include <fmt/base.h>
@@ -12,23 +14,56 @@
 #include <vector>
 
 class ShaderComponent;
+class LayerComponent;
+// Renders a frame only when something has changed or a component is
+// animating, rather than continuously
 class GlynthEditor final : public juce::AudioProcessorEditor,
-                           public juce::OpenGLRenderer {
+                           public juce::OpenGLRenderer,
+                           private juce::AudioProcessorParameter::Listener,
+                           private juce::Timer {
 public:
-  explicit GlynthEditor(GlynthProcessor&, FontManager&);
+  explicit GlynthEditor(GlynthProcessor&);
   ~GlynthEditor() override;
 
   void paint(juce::Graphics&) override;
   void newOpenGLContextCreated() override;
   void renderOpenGL() override;
   void openGLContextClosing() override;
+  // Schedules a frame. Safe from any thread
+  inline void requestRepaint() { m_repaint_requested = true; }
 
 private:
+  // Often enough for smooth animation, and a ceiling on the frame rate
+  static constexpr int s_frame_rate_hz = 60;
+
+  // Re-renders the static layer if it's out of date
+  void updateStaticLayer();
+  // Decides whether to render a frame, on the message thread
+  void timerCallback() override;
+  // Called on whichever thread changed the parameter, including the audio
+  // thread, so it only sets a flag
+  void parameterValueChanged(int, float) override { requestRepaint(); }
+  void parameterGestureChanged(int, bool) override {}
+
   GlynthProcessor& m_processor_ref;
   juce::OpenGLContext m_context;
+  std::atomic<bool> m_repaint_requested = true;
+  // Set once the components exist, since they're created on the GL thread
+  std::atomic<bool> m_components_ready = false;
   ShaderManager m_shader_manager;
-  FontManager& m_font_manager;
+  // Glyph textures belong to this editor's context
+  FontManager m_font_manager;
+  // Created with the context, before any component
+  std::unique_ptr<QuadBatch> m_quad_batch;
+  std::unique_ptr<TextBatch> m_text_batch;
   std::vector<std::unique_ptr<ShaderComponent>> m_shader_components;
+  // What every component draws in renderStatic(), cached at the physical
+  // size of the editor and drawn under the dynamic components each frame
+  juce::OpenGLFrameBuffer m_static_layer;
+  std::unique_ptr<LayerComponent> m_layer_component;
+  // FontManager generation when the layer was drawn, since static text may
+  // have been waiting on glyphs
+  uint64_t m_static_glyph_generation = 0;
 
   friend class ShaderComponent;
 
@@ -38,13 +73,28 @@ private:
 class ShaderComponent : public juce::Component {
 public:
   ShaderComponent(GlynthEditor& editor_ref, const std::string& program_id);
+  // Draws whatever changes between frames
   virtual void renderOpenGL() = 0;
+  // Draws whatever doesn't, into the editor's cached static layer. Only
+  // called again on resize or display scale changes
+  virtual void renderStatic() {}
+  // Polled from the message thread, for state that changes without
+  // requesting a repaint, like animations or data from other threads
+  virtual bool needsFrame() const { return false; }
+  // Deletes the component's GL objects while the context is still current.
+  // The component itself is destroyed later, on the message thread
+  virtual void openGLContextClosing() {}
 
 protected:
+  // Physical pixels per logical pixel. Only call from the OpenGL thread
+  float getRenderingScale() const;
+
   GlynthEditor& m_editor_ref;
   GlynthProcessor& m_processor_ref;
   ShaderManager& m_shader_manager;
   FontManager& m_font_manager;
+  QuadBatch& m_quad_batch;
+  TextBatch& m_text_batch;
   // ID of the shader program associated with this component
   std::string m_program_id;
 
@@ -55,29 +105,49 @@ private:
 class BackgroundComponent : public ShaderComponent {
 public:
   BackgroundComponent(GlynthEditor& editor_ref, const std::string& program_id);
-  ~BackgroundComponent() override;
-  void renderOpenGL() override;
+  // Entirely static
+  void renderOpenGL() override {}
+  void renderStatic() override;
+
+protected:
+  // Draws the shared quad over the whole viewport
+  void drawFullscreen();
 
 private:
-  GLuint m_vbo = 0, m_vao = 0;
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BackgroundComponent)
 };
 
+// Draws a cached layer over the whole editor
+class LayerComponent : public BackgroundComponent {
+public:
+  LayerComponent(GlynthEditor& editor_ref, const std::string& program_id);
+  void renderOpenGL() override;
+  void renderStatic() override {}
+  inline void setTexture(GLuint texture) { m_texture = texture; }
+
+private:
+  GLuint m_texture = 0;
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LayerComponent)
+};
+
 class RectComponent : public ShaderComponent {
 public:
   RectComponent(GlynthEditor& editor_ref, const std::string& program_id);
-  ~RectComponent() override;
+  // Queues the rect with the editor's QuadBatch
   void renderOpenGL() override;
   void paint(juce::Graphics& g) override;
   void resized() override;
 
-private:
-  struct RectVertex {
-    glm::vec2 pos;
-    glm::vec2 uv;
-  };
+protected:
+  // Draws the rect straight away, after binding textures or setting
+  // uniforms that other instances of the program don't share
+  void drawNow();
+
+  // Bottom left corner and size in window pixels
+  glm::vec4 m_rect{0};
 
-  GLuint m_vbo = 0, m_vao = 0, m_ebo = 0;
+private:
+  UniformHandle<glm::mat4> m_projection_uniform;
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RectComponent)
 };
 
@@ -99,15 +169,16 @@ private:
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KnobComponent)
 };
 
+// Adds its glyphs to the editor's TextBatch rather than drawing them itself
 class TextComponent : public ShaderComponent {
 public:
   TextComponent(GlynthEditor& editor_ref, const std::string& program_id,
                 std::string_view text);
-  ~TextComponent() override;
   void renderOpenGL() override;
   void paint(juce::Graphics& g) override;
   void resized() override;
   void setFontFace(std::string_view face_name, FT_UInt pixel_height);
+  void setText(std::string_view text);
 
 protected:
   std::string m_text;
@@ -115,11 +186,17 @@ protected:
   FT_UInt m_pixel_height;
 
 private:
-  GLuint m_vao = 0, m_vbo = 0, m_ebo = 0;
-  struct RectVertex {
-    glm::vec2 pos;
-    glm::vec2 uv;
-  };
+  // Rebuilds the glyph quads, only when the text, face or bounds change
+  void layout();
+
+  std::vector<TextBatch::Vertex> m_quads;
+  UniformHandle<glm::mat4> m_projection_uniform;
+  // Set from the message thread, since layout happens on the GL thread
+  std::atomic<bool> m_layout_dirty = true;
+  // Whether some glyphs were still being rendered at the last layout, and
+  // the FontManager generation then
+  bool m_missing_glyphs = false;
+  uint64_t m_layout_generation = 0;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TextComponent)
 };
@@ -133,6 +210,8 @@ public:
 private:
   juce::AudioParameterFloat& m_param;
   std::string m_format;
+  // Value last formatted, so the text is only rebuilt when it changes
+  std::optional<float> m_value;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NumberComponent)
 };
@@ -141,7 +220,10 @@ class ParameterComponent : public RectComponent {
 public:
   ParameterComponent(GlynthEditor& editor_ref, const std::string& program_id,
                      std::string_view param_id, std::string_view format);
+  // The knob and value
   void renderOpenGL() override;
+  // The frame and label
+  void renderStatic() override;
   void paint(juce::Graphics& g) override;
   void resized() override;
   void mouseDoubleClick(const juce::MouseEvent& e) override;
@@ -158,8 +240,7 @@ private:
 
 class LissajousComponent : public RectComponent {
 public:
-  LissajousComponent(GlynthEditor& editor_ref, const std::string& program_id,
-                     size_t m_num_samples = 512);
+  LissajousComponent(GlynthEditor& editor_ref, const std::string& program_id);
   ~LissajousComponent() override;
   void paint(juce::Graphics& g) override;
   void resized() override;
@@ -168,34 +249,102 @@ public:
   void focusLost(FocusChangeType cause) override;
   bool keyPressed(const juce::KeyPress& key) override;
   void renderOpenGL() override;
+  // While focused for the blinking cursor, or when there's a new outline
+  bool needsFrame() const override;
+  void openGLContextClosing() override;
 
 private:
   static inline std::array s_defocusing_keys = {juce::KeyPress::returnKey,
                                                 juce::KeyPress::escapeKey,
                                                 juce::KeyPress::tabKey};
-  static constexpr FT_UInt s_pixel_height = 20;
+
+  // Side of a grid cell in pixels
+  static constexpr float s_cell_size = 8;
 
   void onContentChanged();
+  // Fits the outline to the component and uploads its samples
+  void layoutOutline(const OutlineSnapshot& snapshot);
+  // Lists the segments near each cell of a grid over the component and
+  // uploads it, so the shader only tests the segments near each pixel.
+  // Returns false if the component has no area to cover
+  bool buildGrid();
   float getTimeUniform();
 
+  OutlineSnapshotStore::Reader m_outline_reader;
+  UniformHandle<float> m_time_uniform;
+  UniformHandle<bool> m_has_outline_uniform;
+  UniformHandle<glm::vec2> m_glyph_corner_uniform;
+  UniformHandle<glm::vec2> m_glyph_size_uniform;
+  UniformHandle<float> m_cell_size_uniform;
+  UniformHandle<int> m_cells_uniform;
+  UniformHandle<int> m_segments_uniform;
+  // Version of the outline last laid out
+  uint64_t m_outline_version = 0;
+  // Snapshots published as of the last frame
+  std::atomic<uint64_t> m_num_published_drawn = 0;
   std::string m_content;
   std::vector<glm::vec2> m_samples;
-  size_t m_num_samples;
   // Bottom left corner of the last glyph
   glm::vec2 m_outline_glyph_corner;
   // Width and height of the last glyph
   glm::vec2 m_outline_glyph_size;
   GLuint m_texture;
-  // Dirty flag since texture cannot be updated in the callback thread
+  // For each cell, bottom row first, the first index into m_cell_segments
+  // and the number of segments
+  std::vector<glm::uvec2> m_cells;
+  // Index of the first sample of each segment near each cell
+  std::vector<GLuint> m_cell_segments;
+  GLuint m_cell_texture;
+  GLuint m_segment_buffer, m_segment_texture;
+  // Set when the bounds change, since layout happens on the GL thread
   std::atomic<bool> m_dirty = false;
   // For focus cursor blinking
   std::chrono::time_point<std::chrono::high_resolution_clock>
       m_last_change_time;
-  bool m_focused = false;
+  std::atomic<bool> m_focused = false;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LissajousComponent)
 };
 
+// Plots the synth's output as points over the Lissajous preview. Points fade
+// out over time, so the trace shows the last few tens of milliseconds
+class VectorscopeComponent : public RectComponent {
+public:
+  VectorscopeComponent(GlynthEditor& editor_ref,
+                       const std::string& program_id);
+  void renderOpenGL() override;
+  // While there are new frames, or old ones still fading out
+  bool needsFrame() const override;
+  void openGLContextClosing() override;
+
+private:
+  // Seconds for a point to fade to 1/e
+  static constexpr float s_persistence = 0.04f;
+  // Seconds until a point has faded out entirely
+  static constexpr float s_fade_time = 6 * s_persistence;
+  // Points in the vertex buffer. Covers the fade time at 96 kHz, and the
+  // oldest points are nearly invisible at 192 kHz
+  static constexpr size_t s_capacity = 1 << 15;
+
+  XYTap& m_tap;
+  UniformHandle<glm::vec2> m_corner_uniform;
+  UniformHandle<glm::vec2> m_size_uniform;
+  UniformHandle<int> m_head_uniform;
+  UniformHandle<int> m_capacity_uniform;
+  UniformHandle<float> m_persistence_uniform;
+  UniformHandle<float> m_idle_uniform;
+  // Ring of points, written in place as frames arrive
+  GLuint m_vao = 0, m_vbo = 0;
+  // Frames drained this frame, reserved up front
+  std::vector<glm::vec2> m_frames;
+  // Index after the newest point, and how many of the points are valid
+  size_t m_head = 0;
+  size_t m_num_points = 0;
+  std::atomic<std::chrono::steady_clock::time_point> m_last_frames_time;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VectorscopeComponent)
+};
+
 class ScopeComponent : public RectComponent {
 public:
   ScopeComponent(GlynthEditor& editor_ref, const std::string& program_id,
@@ -203,11 +352,48 @@ public:
   void renderOpenGL() override;
   void paint(juce::Graphics& g) override;
   void resized() override;
+  bool needsFrame() const override;
+  void openGLContextClosing() override;
 
 private:
+  // Reduces the latest burst to the vertical extent of the trace in each
+  // column, in pixels from the bottom
+  void decimate();
+
   TriggerHandler& m_trigger_handler_ref;
 
   GLuint m_texture;
+  // Latest burst, kept so it can be decimated again on resize
   std::vector<float> m_samples;
+  // One (min, max) pair per physical pixel column, in logical pixels from
+  // the bottom, uploaded as the texture
+  std::vector<glm::vec2> m_columns;
+  // Set when the bounds change, since the texture is sized to the width
   std::atomic_bool m_dirty = false;
 };
+
+#ifdef GLYNTH_LOAD_METER
+// Debug overlay listing the load of each processor stage as a percentage of
+// the block deadline, along with which stages caused deadline misses
+class LoadMeterComponent : public ShaderComponent {
+public:
+  LoadMeterComponent(GlynthEditor& editor_ref, const std::string& program_id);
+  void renderOpenGL() override;
+  void resized() override;
+  // Updates on its own interval, so keeps the editor rendering
+  bool needsFrame() const override { return true; }
+
+private:
+  static constexpr int s_line_height = 12;
+  // Reformatting every frame would be unreadable and wasteful
+  static constexpr auto s_update_interval = std::chrono::milliseconds(250);
+
+  void updateText();
+
+  const LoadMeter& m_load_meter;
+  std::vector<std::unique_ptr<TextComponent>> m_lines;
+  std::chrono::steady_clock::time_point m_last_update;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoadMeterComponent)
+};
+#endif
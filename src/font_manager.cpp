@@ -1,33 +1,11 @@
 
 #include "font_manager.h"
 #include "error.h"
-#include "fonts.h"
+#include "logger.h"
+#include "tracer.h"
 
+#include <algorithm>
 #include <fmt/format.h>
-#include <regex>
-
-FontManager::FontManager() {
-  FT_Error err;
-  if (err = FT_Init_FreeType(&m_library); err != 0) {
-    throw FreetypeError(FT_Error_String(err));
-  }
-
-  // Get max display scale, which is needed to render Freetype fonts correctly.
-  // Freetype doesn't distinguish between logical pixels and physical pixels,
-  // so creates bitmaps at half the desired resolution on high-dpi devices.
-  // Iterating over all display rects gets the max scale for any display, since
-  // scale could differ significantly between computer monitors, for example
-  m_display_scale = std::numeric_limits<decltype(m_display_scale)>::min();
-  auto& displays = juce::Desktop::getInstance().getDisplays();
-  auto rectangle_list = displays.getRectangleList(true);
-  for (int i = 0; i < rectangle_list.getNumRectangles(); i++) {
-    auto rect = rectangle_list.getRectangle(i);
-    auto* display = displays.getDisplayForRect(rect);
-    if (display && display->scale > m_display_scale) {
-      m_display_scale = display->scale;
-    }
-  }
-}
 
 class FontManagerError : public std::runtime_error {
 public:
@@ -35,96 +13,186 @@ public:
   explicit FontManagerError(char* msg) : std::runtime_error(msg) {}
 };
 
-FontManager::~FontManager() { FT_Done_FreeType(m_library); }
+FontManager::FontManager()
+    : m_workers(juce::ThreadPoolOptions{}
+                    .withThreadName("Glynth Glyphs")
+                    .withNumberOfThreads(s_num_workers)) {}
 
-void FontManager::setContext(juce::OpenGLContext& context) {
-  m_context = context;
+FontManager::~FontManager() {
+  // Don't render glyphs nobody will upload
+  m_workers.removeAllJobs(true, 2000);
 }
 
-void FontManager::addFace(std::string_view face_name) {
-  // Load from binary data; assumes face_name is the non-extension filename
-  std::string resource_name = std::string(face_name) + "_ttf";
-  resource_name = std::regex_replace(resource_name, std::regex("-"), "");
-  int file_size;
-  auto file_base = fonts::getNamedResource(resource_name.c_str(), file_size);
-  if (file_base == nullptr) {
-    throw FontManagerError(
-        fmt::format(R"(No resource with name "{}")", resource_name));
-  }
-  if (auto err = FT_New_Memory_Face(
-          m_library, reinterpret_cast<const FT_Byte*>(file_base), file_size, 0,
-          &m_faces[std::string(face_name)])) {
-    throw FreetypeError(FT_Error_String(err));
+void FontManager::releaseAtlas() {
+  using namespace juce::gl;
+  glDeleteTextures(1, &m_atlas_texture);
+  m_atlas_texture = 0;
+  m_shelf_x = m_shelf_y = m_shelf_height = 0;
+  m_charmaps.clear();
+  // Otherwise they'd be uploaded into the next context's atlas, and
+  // isRendering() would stay true with nothing left to upload them
+  m_workers.removeAllJobs(true, 2000);
+  {
+    const std::lock_guard lock(m_ready_mutex);
+    m_ready.clear();
   }
+  m_num_in_flight = 0;
 }
 
-FT_Face FontManager::getFace(std::string_view face_name) {
-  if (auto it = m_faces.find(std::string(face_name)); it != m_faces.end()) {
-    return it->second;
-  } else {
-    throw GlynthError(
-        fmt::format(R"(No face found with name "{}")", face_name));
-  }
+void FontManager::setContext(juce::OpenGLContext& context) {
+  m_context = context;
 }
 
-void FontManager::buildBitmaps(std::string_view face_name,
-                               FT_UInt pixel_height) {
+void FontManager::addFace(std::string_view face_name) {
   assert(m_context.has_value());
-  auto& face = m_faces.at(std::string(face_name));
-  // Render face to bitmaps. Interpret height in logical pixels
-  auto& charmap =
-      m_character_maps[std::make_pair(std::string(face_name), pixel_height)];
-  pixel_height = static_cast<FT_UInt>(pixel_height * m_display_scale);
-  FT_Set_Pixel_Sizes(face, 0, pixel_height);
-  for (size_t i = 0; i < charmap.size(); i++) {
-    Character c(static_cast<FT_ULong>(i), face);
-    // Apply display scaling so they're rendered with pixel_height pixels
-    c.size /= m_display_scale;
-    c.bearing /= m_display_scale;
-    c.advance /= static_cast<float>(m_display_scale);
-    charmap[i] = std::move(c);
+  m_charmaps.try_emplace(std::string(face_name));
+  if (m_atlas_texture == 0) {
+    using namespace juce::gl;
+    glGenTextures(1, &m_atlas_texture);
+    glBindTexture(GL_TEXTURE_2D, m_atlas_texture);
+    // Cleared, so the padding between glyphs reads as far outside
+    std::vector<uint8_t> zeros(s_atlas_size * s_atlas_size, 0);
+    auto size = static_cast<GLsizei>(s_atlas_size);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, size, size, 0, GL_RED,
+                 GL_UNSIGNED_BYTE, zeros.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   }
 }
 
-const FontManager::Character&
-FontManager::getCharacter(std::string_view face_name, char character,
-                          FT_UInt pixel_height) {
+const FontManager::Character*
+FontManager::getCharacter(std::string_view face_name, char character) {
   assert(m_context.has_value());
-  auto key = std::make_pair(std::string(face_name), pixel_height);
-  if (auto it = m_character_maps.find(key); it != m_character_maps.end()) {
-    return it->second[static_cast<size_t>(character)];
-  } else {
+  auto it = m_charmaps.find(std::string(face_name));
+  if (it == m_charmaps.end()) {
     throw FontManagerError(fmt::format(
-        R"(Unable to find Character for '{}' in face "{}" with height {})",
-        character, face_name, pixel_height));
+        R"(Unable to find Character for '{}' in face "{}")", character,
+        face_name));
+  }
+  auto& charmap = it->second;
+  size_t code = static_cast<unsigned char>(character) % 128;
+  if (auto& c = charmap.characters[code]; c.has_value()) {
+    return &*c;
+  }
+  if (!charmap.requested[code]) {
+    charmap.requested[code] = true;
+    m_num_in_flight++;
+    m_workers.addJob([this, face_name = it->first, code] {
+      auto glyph = renderGlyph(face_name, code);
+      const std::lock_guard lock(m_ready_mutex);
+      m_ready.push_back(std::move(glyph));
+    });
   }
+  return nullptr;
 }
 
-FontManager::Character::Character(FT_ULong code, FT_Face face) {
-  if (auto err = FT_Load_Char(face, code, FT_LOAD_RENDER)) {
-    throw FreetypeError(FT_Error_String(err));
+FontManager::RenderedGlyph
+FontManager::renderGlyph(const std::string& face_name, size_t code) {
+  GLYNTH_TRACE_SCOPE("FontManager::renderGlyph");
+  RenderedGlyph rendered{
+      .face_name = face_name,
+      .code = code,
+      .character = {},
+      .width = 0,
+      .rows = 0,
+      .pixels = {},
+  };
+  try {
+    // Lent to this thread alone until it goes out of scope
+    auto face = m_font_registry->acquire(face_name);
+    // Distances don't depend on display scale, so one size serves every DPI
+    FT_Set_Pixel_Sizes(face.get(), 0, s_sdf_pixel_height);
+    // Hinting distorts the field when it's scaled to other sizes
+    if (auto err = FT_Load_Char(face.get(), static_cast<FT_ULong>(code),
+                                FT_LOAD_NO_HINTING)) {
+      throw FreetypeError(FT_Error_String(err));
+    }
+    FT_GlyphSlot glyph = face.get()->glyph;
+    rendered.character.advance = static_cast<float>(glyph->advance.x) / 64;
+    // Glyphs with no points, like ' ', have no field and only advance
+    if (glyph->format != FT_GLYPH_FORMAT_OUTLINE ||
+        glyph->outline.n_points == 0) {
+      return rendered;
+    }
+    if (auto err = FT_Render_Glyph(glyph, FT_RENDER_MODE_SDF)) {
+      throw FreetypeError(FT_Error_String(err));
+    }
+    auto& bitmap = glyph->bitmap;
+    rendered.width = bitmap.width;
+    rendered.rows = bitmap.rows;
+    rendered.pixels.resize(rendered.width * rendered.rows);
+    for (size_t row = 0; row < rendered.rows; row++) {
+      auto* src = bitmap.buffer + static_cast<ptrdiff_t>(row) * bitmap.pitch;
+      std::copy_n(src, rendered.width,
+                  rendered.pixels.data() + row * rendered.width);
+    }
+    rendered.character.size = glm::vec2(rendered.width, rendered.rows);
+    rendered.character.bearing =
+        glm::vec2(glyph->bitmap_left, glyph->bitmap_top);
+  } catch (const std::exception& e) {
+    // Stored empty, so it isn't requested again
+    fmt::println(Logger::file, R"(Unable to render '{}' in face "{}": {})",
+                 static_cast<char>(code), face_name, e.what());
+  }
+  return rendered;
+}
+
+void FontManager::uploadReady() {
+  std::vector<RenderedGlyph> ready;
+  {
+    const std::lock_guard lock(m_ready_mutex);
+    ready.swap(m_ready);
+  }
+  m_num_in_flight -= ready.size();
+  if (ready.empty()) {
+    return;
   }
-  // Read from glyph slot
-  FT_GlyphSlot glyph = face->glyph;
-  size = glm::vec2(glyph->bitmap.width, glyph->bitmap.rows);
-  bearing = glm::vec2(glyph->bitmap_left, glyph->bitmap_top);
-  advance = static_cast<float>(glyph->advance.x) / 64;
-  // Create texture from bitmap
   using namespace juce::gl;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
+  glBindTexture(GL_TEXTURE_2D, m_atlas_texture);
   // Disable byte-alignment restriction
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-  // Some characters, like ' ', are actually zero-width, which
-  // confuses OpenGL, since all textures must be at least 1x1. This
-  // snapping is going to fill a single pixel with a garbage value, but
-  // the computed width will be zero, so nothing will be displayed
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED,
-               static_cast<GLsizei>(std::max(glyph->bitmap.width, 1u)),
-               static_cast<GLsizei>(std::max(glyph->bitmap.rows, 1u)), 0,
-               GL_RED, GL_UNSIGNED_BYTE, glyph->bitmap.buffer);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  for (auto& glyph : ready) {
+    auto it = m_charmaps.find(glyph.face_name);
+    if (it != m_charmaps.end() && it->second.requested[glyph.code]) {
+      addGlyph(glyph);
+      it->second.characters[glyph.code] = glyph.character;
+    }
+  }
+  m_generation++;
+}
+
+void FontManager::addGlyph(RenderedGlyph& glyph) {
+  size_t width = glyph.width;
+  size_t rows = glyph.rows;
+  if (width == 0 || rows == 0) {
+    return;
+  }
+  if (m_shelf_x + width + s_atlas_padding > s_atlas_size) {
+    // Start a new shelf below the tallest glyph on this one
+    m_shelf_x = 0;
+    m_shelf_y += m_shelf_height + s_atlas_padding;
+    m_shelf_height = 0;
+  }
+  if (m_shelf_y + rows > s_atlas_size) {
+    // Runs on the render thread, so there's nowhere to throw to. Kept with
+    // its advance but no area, so text still lays out around it
+    fmt::println(Logger::file, R"(Glyph atlas is full, dropping '{}' in "{}")",
+                 static_cast<char>(glyph.code), glyph.face_name);
+    glyph.character.size = glm::vec2(0);
+    return;
+  }
+  using namespace juce::gl;
+  glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(m_shelf_x),
+                  static_cast<GLint>(m_shelf_y), static_cast<GLsizei>(width),
+                  static_cast<GLsizei>(rows), GL_RED, GL_UNSIGNED_BYTE,
+                  glyph.pixels.data());
+
+  float atlas_size = static_cast<float>(s_atlas_size);
+  glyph.character.uv_min = glm::vec2(m_shelf_x, m_shelf_y) / atlas_size;
+  glyph.character.uv_max =
+      glm::vec2(m_shelf_x + width, m_shelf_y + rows) / atlas_size;
+  m_shelf_x += width + s_atlas_padding;
+  m_shelf_height = std::max(m_shelf_height, rows);
 }
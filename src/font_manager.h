@@ -1,51 +1,103 @@
 #pragma once
 
+#include "font_registry.h"
+
 #include <fmt/base.h>
 #include <freetype/freetype.h>
 #include <glm/glm.hpp>
+#include <atomic>
 #include <juce_opengl/juce_opengl.h>
+#include <mutex>
+#include <vector>
 
+// Signed distance fields of glyphs for one editor's GL context, packed into
+// a single atlas texture so all text can be drawn in one call. Each face is
+// rendered once at a reference height, and char.frag reconstructs sharp edges
+// from it at any pixel height or display scale. Faces come from the shared
+// FontRegistry
+//
+// Glyphs are rendered on demand on worker threads, each with its own face
+// from the registry, and only uploaded on the GL thread. Everything other
+// than the workers is called from the GL thread
 class FontManager {
 public:
+  // Height that fields are rendered at, which metrics are relative to
+  static constexpr FT_UInt s_sdf_pixel_height = 32;
+
   struct Character {
-    Character() = default;
-    Character(FT_ULong code, FT_Face face);
+    // Metrics in pixels at s_sdf_pixel_height. The size and bearing include
+    // the spread of the field around the glyph
     glm::vec2 size;
     glm::vec2 bearing;
     float advance;
-    GLuint texture;
+    // Corners of the bitmap in the atlas. uv_min is the top left, since
+    // FreeType bitmaps start from the top row
+    glm::vec2 uv_min;
+    glm::vec2 uv_max;
   };
 
   FontManager();
   ~FontManager();
   void setContext(juce::OpenGLContext& context);
+  // Frees the atlas and every glyph. Call while the context is still active
+  void releaseAtlas();
+  // Makes the face available. Nothing is rendered until it's used
   void addFace(std::string_view face_name);
-  FT_Face getFace(std::string_view face_name);
-  void buildBitmaps(std::string_view face_name, FT_UInt pixel_height);
-  const Character& getCharacter(std::string_view face_name, char character,
-                                FT_UInt pixel_height);
+  // Returns nullptr while the glyph is being rendered, and queues it if
+  // it hasn't been requested yet
+  const Character* getCharacter(std::string_view face_name, char character);
+  // Uploads glyphs finished since the last call. Call once per frame
+  void uploadReady();
+  inline GLuint getAtlasTexture() const { return m_atlas_texture; }
+  // Increases whenever glyphs are added, so text missing some can lay out
+  // again
+  inline uint64_t getGeneration() const { return m_generation; }
+  // Whether glyphs are being rendered or waiting for upload. Safe from any
+  // thread
+  inline bool isRendering() const { return m_num_in_flight > 0; }
 
 private:
-  struct pair_hash final {
-  public:
-    // See https://stackoverflow.com/a/55083395
-    template <typename T, typename U>
-    size_t operator()(const std::pair<T, U>& p) const noexcept {
-      uintmax_t hash = std::hash<T>{}(p.first);
-      hash <<= sizeof(uintmax_t) * 4;
-      hash ^= std::hash<U>{}(p.second);
-      return std::hash<uintmax_t>{}(hash);
-    }
+  // Side length in texels. Room for about four faces
+  static constexpr size_t s_atlas_size = 1024;
+  // Gap between glyphs so linear filtering doesn't bleed into neighbours
+  static constexpr size_t s_atlas_padding = 1;
+  static constexpr int s_num_workers = 2;
+
+  // Rendered by a worker, waiting for upload
+  struct RenderedGlyph {
+    std::string face_name;
+    size_t code;
+    Character character;
+    size_t width;
+    size_t rows;
+    std::vector<uint8_t> pixels;
   };
 
+  struct Charmap {
+    std::array<std::optional<Character>, 128> characters;
+    std::array<bool, 128> requested{};
+  };
+
+  RenderedGlyph renderGlyph(const std::string& face_name, size_t code);
+  // Reserves space in the atlas and uploads the bitmap there. If the atlas
+  // is full, logs it and leaves the glyph without a bitmap
+  void addGlyph(RenderedGlyph& glyph);
+
   std::optional<std::reference_wrapper<juce::OpenGLContext>> m_context;
-  FT_Library m_library;
-  std::unordered_map<std::string, FT_Face> m_faces;
-  // Maps the pair (face_name, pixel_height) -> charmap
-  std::unordered_map<std::pair<std::string, FT_UInt>,
-                     std::array<Character, 128>, pair_hash>
-      m_character_maps;
-  // For fetching display scale
-  double m_display_scale;
+  juce::SharedResourcePointer<FontRegistry> m_font_registry;
+  // Maps face_name -> charmap
+  std::unordered_map<std::string, Charmap> m_charmaps;
+  uint64_t m_generation = 0;
+  // Packed in shelves, left to right and then top to bottom
+  size_t m_shelf_x = 0;
+  size_t m_shelf_y = 0;
+  size_t m_shelf_height = 0;
+  GLuint m_atlas_texture = 0;
+  std::mutex m_ready_mutex;
+  std::vector<RenderedGlyph> m_ready;
+  // Queued glyphs not yet taken by uploadReady()
+  std::atomic<size_t> m_num_in_flight = 0;
   juce::MessageManager::Lock m_message_lock;
+  // Last, so jobs finish before anything they use is destroyed
+  juce::ThreadPool m_workers;
 };
@@ -0,0 +1,67 @@
+#include "font_registry.h"
+#include "error.h"
+#include "fonts.h"
+
+#include <fmt/format.h>
+#include <utility>
+
+FontRegistry::ScopedFace::ScopedFace(FontRegistry& registry,
+                                     std::string face_name, FT_Face face)
+    : m_registry(&registry), m_face_name(std::move(face_name)),
+      m_face(face) {}
+
+FontRegistry::ScopedFace::ScopedFace(ScopedFace&& other) noexcept
+    : m_registry(std::exchange(other.m_registry, nullptr)),
+      m_face_name(std::move(other.m_face_name)), m_face(other.m_face) {}
+
+FontRegistry::ScopedFace::~ScopedFace() {
+  if (m_registry != nullptr) {
+    m_registry->release(m_face_name, m_face);
+  }
+}
+
+FontRegistry::FontRegistry() {
+  if (auto err = FT_Init_FreeType(&m_library)) {
+    throw FreetypeError(FT_Error_String(err));
+  }
+}
+
+FontRegistry::~FontRegistry() {
+  jassert(m_num_lent == 0);
+  // Also closes every face
+  FT_Done_FreeType(m_library);
+}
+
+FontRegistry::ScopedFace FontRegistry::acquire(std::string_view face_name) {
+  const std::lock_guard lock(m_mutex);
+  auto& idle = m_idle_faces[std::string(face_name)];
+  FT_Face face;
+  if (!idle.empty()) {
+    face = idle.back();
+    idle.pop_back();
+  } else {
+    // Resources are named after the file, without punctuation
+    std::string resource_name = std::string(face_name) + "_ttf";
+    std::erase(resource_name, '-');
+    int file_size;
+    auto file_base = fonts::getNamedResource(resource_name.c_str(), file_size);
+    if (file_base == nullptr) {
+      throw GlynthError(
+          fmt::format(R"(No face found with name "{}")", face_name));
+    }
+    // Faces read straight from the embedded data, so it's never copied
+    if (auto err = FT_New_Memory_Face(
+            m_library, reinterpret_cast<const FT_Byte*>(file_base),
+            file_size, 0, &face)) {
+      throw FreetypeError(FT_Error_String(err));
+    }
+  }
+  m_num_lent++;
+  return ScopedFace(*this, std::string(face_name), face);
+}
+
+void FontRegistry::release(const std::string& face_name, FT_Face face) {
+  const std::lock_guard lock(m_mutex);
+  m_idle_faces[face_name].push_back(face);
+  m_num_lent--;
+}
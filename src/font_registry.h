@@ -0,0 +1,55 @@
+#pragma once
+
+#include <freetype/freetype.h>
+#include <juce_core/juce_core.h>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Opens the bundled fonts once for the whole process, shared by all plugin
+// instances through juce::SharedResourcePointer<FontRegistry>. FreeType faces
+// can only be used by one thread at a time, so a face is lent out to one
+// thread at a time, and a new one is only opened when every existing face
+// with that name is in use
+class FontRegistry {
+public:
+  // Exclusive use of a face until destroyed, so it can be used without
+  // locking. Must not outlive the registry
+  class ScopedFace {
+  public:
+    ScopedFace(ScopedFace&& other) noexcept;
+    ~ScopedFace();
+    inline FT_Face get() const { return m_face; }
+    inline FT_Face operator->() const { return m_face; }
+
+  private:
+    friend class FontRegistry;
+    ScopedFace(FontRegistry& registry, std::string face_name, FT_Face face);
+
+    FontRegistry* m_registry;
+    std::string m_face_name;
+    FT_Face m_face;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedFace)
+  };
+
+  FontRegistry();
+  ~FontRegistry();
+  // Takes an idle face with this name, or opens another. The name is the
+  // font's filename without the extension, like "SplineSansMono-Medium"
+  ScopedFace acquire(std::string_view face_name);
+
+private:
+  void release(const std::string& face_name, FT_Face face);
+
+  // Guards the library, which can't open or close faces concurrently, and
+  // the idle faces
+  std::mutex m_mutex;
+  FT_Library m_library;
+  std::unordered_map<std::string, std::vector<FT_Face>> m_idle_faces;
+  size_t m_num_lent = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FontRegistry)
+};
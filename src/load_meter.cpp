@@ -0,0 +1,110 @@
+#include "load_meter.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+// Single writer, so a plain load and store is enough and avoids a locked
+// instruction on the audio thread
+static inline void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount,
+                std::memory_order_relaxed);
+}
+
+LoadMeter::LoadMeter(std::vector<std::string> stage_names)
+    : m_names(std::move(stage_names)), m_stages(m_names.size()) {}
+
+void LoadMeter::prepareToPlay(double sample_rate, int samples_per_block) {
+  double deadline_s = samples_per_block / sample_rate;
+  m_deadline_ns = static_cast<uint64_t>(deadline_s * 1e9);
+  for (auto& stage : m_stages) {
+    for (auto& bucket : stage.buckets) {
+      bucket = 0;
+    }
+    stage.count = 0;
+    stage.total_ns = 0;
+    stage.max_ns = 0;
+    stage.misses = 0;
+  }
+  m_blocks = 0;
+  m_misses = 0;
+  m_slowest_stage = 0;
+  m_slowest_ns = 0;
+}
+
+void LoadMeter::record(size_t stage_index, clock::duration elapsed) {
+  auto ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  auto& stage = m_stages[stage_index];
+  bump(stage.buckets[bucket(ns)]);
+  bump(stage.count);
+  bump(stage.total_ns, ns);
+  if (ns > stage.max_ns.load(std::memory_order_relaxed)) {
+    stage.max_ns.store(ns, std::memory_order_relaxed);
+  }
+  if (ns >= m_slowest_ns) {
+    m_slowest_ns = ns;
+    m_slowest_stage = stage_index;
+  }
+}
+
+void LoadMeter::endBlock(clock::duration elapsed) {
+  auto ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  bump(m_blocks);
+  uint64_t deadline_ns = m_deadline_ns.load(std::memory_order_relaxed);
+  if (deadline_ns > 0 && ns > deadline_ns && !m_stages.empty()) {
+    bump(m_misses);
+    bump(m_stages[m_slowest_stage].misses);
+  }
+  m_slowest_stage = 0;
+  m_slowest_ns = 0;
+}
+
+LoadMeter::Stats LoadMeter::getStats() const {
+  Stats stats;
+  stats.blocks = m_blocks.load(std::memory_order_relaxed);
+  stats.misses = m_misses.load(std::memory_order_relaxed);
+  double deadline_ns =
+      static_cast<double>(m_deadline_ns.load(std::memory_order_relaxed));
+  stats.deadline_ms = deadline_ns / 1e6;
+  // Avoid dividing by zero before prepareToPlay
+  double scale = deadline_ns > 0 ? 1 / deadline_ns : 0;
+  for (size_t i = 0; i < m_stages.size(); i++) {
+    auto& stage = m_stages[i];
+    std::array<uint64_t, s_num_buckets> buckets;
+    uint64_t count = 0;
+    for (size_t b = 0; b < s_num_buckets; b++) {
+      buckets[b] = stage.buckets[b].load(std::memory_order_relaxed);
+      count += buckets[b];
+    }
+    // Upper edge of the bucket containing the 99th percentile
+    double p99_ns = 0;
+    uint64_t threshold = count - count / 100;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < s_num_buckets && count > 0; b++) {
+      seen += buckets[b];
+      if (seen >= threshold) {
+        p99_ns = std::ldexp(1.0, static_cast<int>(b));
+        break;
+      }
+    }
+    auto total_ns =
+        static_cast<double>(stage.total_ns.load(std::memory_order_relaxed));
+    auto max_ns =
+        static_cast<double>(stage.max_ns.load(std::memory_order_relaxed));
+    stats.stages.push_back(StageStats{
+        .name = m_names[i],
+        .count = count,
+        .mean = count > 0 ? total_ns / static_cast<double>(count) * scale : 0,
+        .p99 = p99_ns * scale,
+        .max = max_ns * scale,
+        .misses = stage.misses.load(std::memory_order_relaxed),
+    });
+  }
+  return stats;
+}
+
+size_t LoadMeter::bucket(uint64_t ns) {
+  return std::min(static_cast<size_t>(std::bit_width(ns)), s_num_buckets - 1);
+}
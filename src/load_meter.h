@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Timing statistics for each SubProcessor in GlynthProcessor::processBlock.
+// The audio thread is the only writer, so counters are bumped with relaxed
+// load/store pairs instead of read-modify-writes, and any other thread can
+// read them without ever blocking the audio thread. Only used when built with
+// GLYNTH_LOAD_METER, so there is no cost otherwise
+class LoadMeter {
+public:
+  using clock = std::chrono::steady_clock;
+  // Bucket b counts durations in [2^(b - 1), 2^b) nanoseconds
+  static constexpr size_t s_num_buckets = 32;
+
+  struct StageStats {
+    std::string name;
+    uint64_t count;
+    // Fractions of the block deadline
+    double mean;
+    double p99;
+    double max;
+    // Deadline misses where this was the slowest stage
+    uint64_t misses;
+  };
+
+  struct Stats {
+    uint64_t blocks;
+    uint64_t misses;
+    double deadline_ms;
+    std::vector<StageStats> stages;
+  };
+
+  explicit LoadMeter(std::vector<std::string> stage_names);
+  // Clears all statistics. Must not run concurrently with processBlock
+  void prepareToPlay(double sample_rate, int samples_per_block);
+
+  inline static clock::time_point now() { return clock::now(); }
+  // Audio thread only. Records how long a stage took this block
+  void record(size_t stage, clock::duration elapsed);
+  // Audio thread only. Records the whole block and attributes a missed
+  // deadline to the slowest stage
+  void endBlock(clock::duration elapsed);
+
+  // Safe to call from any thread
+  Stats getStats() const;
+
+private:
+  struct alignas(64) Stage {
+    std::array<std::atomic<uint64_t>, s_num_buckets> buckets{};
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> total_ns = 0;
+    std::atomic<uint64_t> max_ns = 0;
+    std::atomic<uint64_t> misses = 0;
+  };
+
+  static size_t bucket(uint64_t ns);
+
+  std::vector<std::string> m_names;
+  std::vector<Stage> m_stages;
+  std::atomic<uint64_t> m_deadline_ns = 0;
+  std::atomic<uint64_t> m_blocks = 0;
+  std::atomic<uint64_t> m_misses = 0;
+  // Audio thread state for the block in progress
+  size_t m_slowest_stage = 0;
+  uint64_t m_slowest_ns = 0;
+};
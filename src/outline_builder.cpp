@@ -0,0 +1,205 @@
+#include "outline_builder.h"
+#include "error.h"
+#include "logger.h"
+#include "outline_pack.h"
+#include "tracer.h"
+
+OutlineBuilder::OutlineBuilder(OutlineSnapshotStore& snapshots)
+    : juce::Thread("Glynth Outline Builder"), m_snapshots(snapshots) {
+  startThread(juce::Thread::Priority::normal);
+}
+
+OutlineBuilder::~OutlineBuilder() {
+  // Any build in progress sees that it was superseded and returns early
+  m_requested++;
+  signalThreadShouldExit();
+  notify();
+  stopThread(2000);
+}
+
+void OutlineBuilder::request(std::string_view text,
+                             std::string_view face_name) {
+  {
+    const juce::ScopedLock lock(m_request_lock);
+    m_pending = Request{
+        .text = std::string(text),
+        .face_name = std::string(face_name),
+        .generation = ++m_requested,
+    };
+  }
+  notify();
+}
+
+void OutlineBuilder::restore(std::string_view text, std::string_view face_name,
+                             std::shared_ptr<const OutlineData> data) {
+  Request request;
+  {
+    const juce::ScopedLock lock(m_request_lock);
+    m_pending = std::nullopt;
+    request = Request{
+        .text = std::string(text),
+        .face_name = std::string(face_name),
+        .generation = ++m_requested,
+    };
+  }
+  const std::lock_guard build_lock(m_build_mutex);
+  publish(request, std::move(data));
+}
+
+bool OutlineBuilder::waitUntilIdle(int timeout_ms) {
+  auto deadline = juce::Time::getMillisecondCounter() +
+                  static_cast<juce::uint32>(timeout_ms);
+  while (m_finished < m_requested) {
+    auto now = juce::Time::getMillisecondCounter();
+    if (now >= deadline ||
+        !m_finished_event.wait(static_cast<double>(deadline - now))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void OutlineBuilder::fillWavetable(OutlineData& data) {
+  auto& bbox = data.bbox;
+  auto& wavetable = data.wavetable;
+  size_t n = WavetableSamples::s_num_samples;
+  auto samples = data.outline.sample(n);
+  if (samples.empty()) {
+    // Text with no segments, like a space, is silent
+    wavetable.ch0.fill(0);
+    wavetable.ch1.fill(0);
+    return;
+  }
+  float x_mean = 0;
+  float y_mean = 0;
+  for (size_t i = 0; i < n; i++) {
+    wavetable.ch0[i] = (samples[i].x - bbox.min.x) / bbox.width() * 2;
+    wavetable.ch1[i] = (samples[i].y - bbox.min.y) / bbox.height() * 2;
+    x_mean += wavetable.ch0[i];
+    y_mean += wavetable.ch1[i];
+  }
+  x_mean /= static_cast<float>(n);
+  y_mean /= static_cast<float>(n);
+  // Subtract the mean so there's no DC component
+  for (size_t i = 0; i < n; i++) {
+    wavetable.ch0[i] -= x_mean;
+    wavetable.ch1[i] -= y_mean;
+  }
+}
+
+void OutlineBuilder::run() {
+  while (!threadShouldExit()) {
+    std::optional<Request> request;
+    {
+      const juce::ScopedLock lock(m_request_lock);
+      request = std::exchange(m_pending, std::nullopt);
+    }
+    if (request.has_value()) {
+      build(*request);
+    } else {
+      wait(-1);
+    }
+  }
+}
+
+void OutlineBuilder::build(const Request& request) {
+  GLYNTH_TRACE_SCOPE("OutlineBuilder::build");
+  const std::lock_guard build_lock(m_build_mutex);
+  if (isSuperseded(request.generation)) {
+    finish(request.generation);
+    return;
+  }
+
+  OutlineCache::Key key{
+      .face_name = request.face_name,
+      .text = request.text,
+      .pixel_height = s_pixel_height,
+  };
+  auto data = m_cache->find(key);
+  if (data == nullptr) {
+    data = buildData(request);
+    if (data == nullptr) {
+      finish(request.generation);
+      return;
+    }
+    m_cache->insert(key, data);
+  }
+  publish(request, std::move(data));
+}
+
+void OutlineBuilder::publish(const Request& request,
+                             std::shared_ptr<const OutlineData> data) {
+  auto snapshot = std::make_unique<OutlineSnapshot>();
+  snapshot->version = request.generation;
+  snapshot->text = request.text;
+  snapshot->face_name = request.face_name;
+  snapshot->data = std::move(data);
+  m_snapshots.publish(std::move(snapshot));
+  finish(request.generation);
+}
+
+void OutlineBuilder::finish(uint64_t generation) {
+  // Cancelled builds count as finished, since a newer request will follow
+  m_finished = std::max(m_finished.load(), generation);
+  m_finished_event.signal();
+}
+
+std::shared_ptr<const OutlineData>
+OutlineBuilder::buildData(const Request& request) {
+  auto data = std::make_shared<OutlineData>();
+  // Bundled faces are precomputed, so FreeType is only needed for anything
+  // the pack doesn't cover
+  auto& pack = OutlinePack::getBundled();
+  auto* pack_face = pack.findFace(request.face_name);
+  if (pack_face != nullptr && pack.covers(*pack_face, request.text)) {
+    buildFromPack(request.text, pack, *pack_face, *data);
+  } else {
+    try {
+      buildFromFace(request, *data);
+    } catch (const std::exception& e) {
+      fmt::println(Logger::file, R"(Unable to build outline for "{}": {})",
+                   request.text, e.what());
+      return nullptr;
+    }
+  }
+  // The outline is the expensive part, so check again before sampling
+  if (isSuperseded(request.generation)) {
+    return nullptr;
+  }
+
+  data->samples = data->outline.sample(s_num_preview_samples);
+  data->bbox = data->outline.bbox();
+  data->has_wavetable = !request.text.empty();
+  fillWavetable(*data);
+  return data;
+}
+
+void OutlineBuilder::buildFromPack(std::string_view text,
+                                   const OutlinePack& pack,
+                                   const OutlinePack::Face& face,
+                                   OutlineData& data) {
+  data.outline = Outline(text, pack, face, s_pixel_height);
+  float scale = static_cast<float>(s_pixel_height) / face.units_per_em;
+  data.face_height = face.height * scale;
+  data.descender = face.descender * scale;
+  // Used to place the cursor over the last glyph
+  char c = text.empty() ? 'x' : text.back();
+  data.last_glyph_width = pack.glyph(face, c).width * scale;
+}
+
+void OutlineBuilder::buildFromFace(const Request& request, OutlineData& data) {
+  auto scoped_face = m_font_registry->acquire(request.face_name);
+  FT_Face face = scoped_face.get();
+  data.outline = Outline(request.text, face, s_pixel_height);
+  auto& metrics = face->size->metrics;
+  data.face_height = static_cast<float>(metrics.height) / 64;
+  data.descender = static_cast<float>(metrics.descender) / 64;
+  // Used to place the cursor over the last glyph
+  FT_ULong char_code = request.text.empty()
+                           ? 'x'
+                           : static_cast<FT_ULong>(request.text.back());
+  if (auto err = FT_Load_Char(face, char_code, FT_LOAD_DEFAULT)) {
+    throw FreetypeError(FT_Error_String(err));
+  }
+  data.last_glyph_width = static_cast<float>(face->glyph->metrics.width) / 64;
+}
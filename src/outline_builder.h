@@ -0,0 +1,76 @@
+#pragma once
+
+#include "font_registry.h"
+#include "outline_cache.h"
+#include "outline_snapshot.h"
+#include "outliner.h"
+
+#include <atomic>
+#include <juce_core/juce_core.h>
+#include <mutex>
+#include <optional>
+
+// Builds outlines on a worker thread so typing never blocks the message
+// thread. Requests are coalesced so only the latest text gets built, and a
+// build that gets superseded part way through is thrown away. Each finished
+// build is published to the snapshot store, and outlines built before are
+// taken from the cache instead
+class OutlineBuilder : private juce::Thread {
+public:
+  static constexpr FT_UInt s_pixel_height = 20;
+  // Far denser than the wavetable, since the preview only tests the
+  // segments near each pixel, so its cost barely depends on this
+  static constexpr size_t s_num_preview_samples = 2048;
+
+  explicit OutlineBuilder(OutlineSnapshotStore& snapshots);
+  ~OutlineBuilder() override;
+
+  // Never call from the audio thread. Returns immediately
+  void request(std::string_view text, std::string_view face_name);
+  // Publishes data saved from an earlier build, replacing any pending
+  // request. Never call from the audio thread
+  void restore(std::string_view text, std::string_view face_name,
+               std::shared_ptr<const OutlineData> data);
+  // Blocks until the latest request has been published, or the timeout
+  // expires. Returns false on timeout
+  bool waitUntilIdle(int timeout_ms);
+
+private:
+  struct Request {
+    std::string text;
+    std::string face_name;
+    uint64_t generation;
+  };
+
+  void run() override;
+  void build(const Request& request);
+  // Returns nullptr if the build failed or was superseded
+  std::shared_ptr<const OutlineData> buildData(const Request& request);
+  // Fill the outline and metrics. The pack is unhinted but needs no
+  // FreeType, so it's preferred whenever it covers the text
+  static void buildFromPack(std::string_view text, const OutlinePack& pack,
+                            const OutlinePack::Face& face, OutlineData& data);
+  void buildFromFace(const Request& request, OutlineData& data);
+  void publish(const Request& request, std::shared_ptr<const OutlineData> data);
+  void finish(uint64_t generation);
+  inline bool isSuperseded(uint64_t generation) const {
+    return m_requested.load(std::memory_order_relaxed) != generation;
+  }
+  // Samples the outline again at the wavetable's length
+  static void fillWavetable(OutlineData& data);
+
+  OutlineSnapshotStore& m_snapshots;
+  juce::SharedResourcePointer<FontRegistry> m_font_registry;
+  juce::SharedResourcePointer<OutlineCache> m_cache;
+  juce::CriticalSection m_request_lock;
+  std::optional<Request> m_pending;
+  // Generation of the newest request, and of the last one finished or
+  // cancelled
+  std::atomic<uint64_t> m_requested = 0;
+  std::atomic<uint64_t> m_finished = 0;
+  juce::WaitableEvent m_finished_event;
+  // Serializes builds so snapshots are published in order
+  std::mutex m_build_mutex;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutlineBuilder)
+};
@@ -0,0 +1,43 @@
+#include "outline_cache.h"
+
+size_t OutlineCache::KeyHash::operator()(const Key& key) const noexcept {
+  // See https://stackoverflow.com/a/55083395
+  uintmax_t hash = std::hash<std::string>{}(key.face_name);
+  hash <<= sizeof(uintmax_t) * 4;
+  hash ^= std::hash<std::string>{}(key.text);
+  hash ^= key.pixel_height;
+  return std::hash<uintmax_t>{}(hash);
+}
+
+std::shared_ptr<const OutlineData> OutlineCache::find(const Key& key) {
+  const std::lock_guard lock(m_mutex);
+  auto it = m_index.find(key);
+  if (it == m_index.end()) {
+    return nullptr;
+  }
+  // Move to the front, since it was just used
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  return it->second->data;
+}
+
+void OutlineCache::insert(const Key& key,
+                          std::shared_ptr<const OutlineData> data) {
+  const std::lock_guard lock(m_mutex);
+  if (auto it = m_index.find(key); it != m_index.end()) {
+    // Another instance built the same outline at the same time
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return;
+  }
+  size_t bytes = data->bytes();
+  m_entries.push_front(Entry{key, std::move(data), bytes});
+  m_index.emplace(key, m_entries.begin());
+  m_bytes += bytes;
+  // Always keep the newest entry, even if it's over budget on its own.
+  // Snapshots still using an evicted entry keep it alive until they're done
+  while (m_bytes > s_max_bytes && m_entries.size() > 1) {
+    auto& oldest = m_entries.back();
+    m_bytes -= oldest.bytes;
+    m_index.erase(oldest.key);
+    m_entries.pop_back();
+  }
+}
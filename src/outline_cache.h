@@ -0,0 +1,53 @@
+#pragma once
+
+#include "outline_snapshot.h"
+
+#include <freetype/freetype.h>
+#include <juce_core/juce_core.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Least recently used cache of built outlines, keyed by face, text and pixel
+// height. Retyping text, switching presets, or running several instances
+// with the same text then reuses the outline, its arc-length tables and its
+// wavetable instead of rebuilding them. Shared by all plugin instances
+// through juce::SharedResourcePointer<OutlineCache>
+class OutlineCache {
+public:
+  // Evicts the least recently used entries beyond this
+  static constexpr size_t s_max_bytes = 32 << 20;
+
+  struct Key {
+    std::string face_name;
+    std::string text;
+    FT_UInt pixel_height;
+
+    bool operator==(const Key& other) const = default;
+  };
+
+  OutlineCache() = default;
+  // Returns nullptr on a miss
+  std::shared_ptr<const OutlineData> find(const Key& key);
+  void insert(const Key& key, std::shared_ptr<const OutlineData> data);
+
+private:
+  struct KeyHash {
+    size_t operator()(const Key& key) const noexcept;
+  };
+  struct Entry {
+    Key key;
+    std::shared_ptr<const OutlineData> data;
+    size_t bytes;
+  };
+
+  std::mutex m_mutex;
+  // Most recently used first
+  std::list<Entry> m_entries;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+  size_t m_bytes = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutlineCache)
+};
@@ -0,0 +1,76 @@
+#include "outline_pack.h"
+#include "outline_pack_data.h"
+
+#include <cstring>
+
+OutlinePack::OutlinePack(const void* data, size_t size) {
+  if (data == nullptr || size < sizeof(Header)) {
+    return;
+  }
+  auto* bytes = static_cast<const std::byte*>(data);
+  if (reinterpret_cast<uintptr_t>(bytes) % alignof(uint32_t) != 0) {
+    // Binary data is only guaranteed to be byte-aligned
+    m_aligned_copy.resize((size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    std::memcpy(m_aligned_copy.data(), data, size);
+    bytes = reinterpret_cast<const std::byte*>(m_aligned_copy.data());
+  }
+  auto& header = *reinterpret_cast<const Header*>(bytes);
+  if (header.magic != s_magic || header.version != s_version) {
+    return;
+  }
+  size_t num_glyphs = size_t{header.num_faces} * s_num_chars;
+  size_t faces_offset = sizeof(Header);
+  size_t glyphs_offset = faces_offset + header.num_faces * sizeof(Face);
+  size_t segments_offset = glyphs_offset + num_glyphs * sizeof(Glyph);
+  size_t end = segments_offset + header.num_segments * sizeof(Segment);
+  if (end != size) {
+    return;
+  }
+  auto* faces = reinterpret_cast<const Face*>(bytes + faces_offset);
+  auto* glyphs = reinterpret_cast<const Glyph*>(bytes + glyphs_offset);
+  auto* segments = reinterpret_cast<const Segment*>(bytes + segments_offset);
+  // Check every index once here, so lookups can skip it
+  for (size_t i = 0; i < header.num_faces; i++) {
+    if (size_t{faces[i].first_glyph} + s_num_chars > num_glyphs) {
+      return;
+    }
+  }
+  for (size_t i = 0; i < num_glyphs; i++) {
+    auto& glyph = glyphs[i];
+    if (size_t{glyph.first_segment} + glyph.num_segments >
+        header.num_segments) {
+      return;
+    }
+  }
+  m_faces = {faces, header.num_faces};
+  m_glyphs = {glyphs, num_glyphs};
+  m_segments = {segments, header.num_segments};
+}
+
+const OutlinePack& OutlinePack::getBundled() {
+  static const OutlinePack pack(
+      outline_pack_data::outlines_pack,
+      static_cast<size_t>(outline_pack_data::outlines_packSize));
+  return pack;
+}
+
+const OutlinePack::Face*
+OutlinePack::findFace(std::string_view face_name) const {
+  for (auto& face : m_faces) {
+    size_t length = strnlen(face.name, sizeof(face.name));
+    if (face_name == std::string_view(face.name, length)) {
+      return &face;
+    }
+  }
+  return nullptr;
+}
+
+bool OutlinePack::covers(const Face& face, std::string_view text) const {
+  for (char c : text) {
+    if (static_cast<unsigned char>(c) >= s_num_chars ||
+        !glyph(face, c).is_outline) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Glyph outlines for the bundled fonts in font units, with segment lengths
+// and bounding boxes already computed. It's generated at build time by
+// `read --pack` and embedded as binary data, so outlines can be assembled
+// by scaling and offsetting segments, without FreeType or any parsing. The
+// pack is a run of fixed-size records, all 4-byte aligned:
+//
+//   Header | Face[num_faces] | Glyph[num_faces * s_num_chars] | Segment[...]
+class OutlinePack {
+public:
+  static constexpr uint32_t s_magic = 0x504f4c47; // "GLOP"
+  static constexpr uint32_t s_version = 1;
+  // Glyphs are stored for character codes below this
+  static constexpr uint32_t s_num_chars = 128;
+
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_faces;
+    uint32_t num_segments;
+  };
+
+  struct Face {
+    // Font filename without the extension, null-terminated
+    char name[48];
+    float units_per_em;
+    float height;
+    float descender;
+    uint32_t first_glyph;
+  };
+
+  struct Glyph {
+    float advance;
+    float width;
+    // Control box of the outline, or all zero if it has no points
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+    uint32_t first_segment;
+    uint32_t num_segments;
+    // False for bitmap glyphs, which Outline can't trace
+    uint32_t is_outline;
+  };
+
+  struct Segment {
+    // 0 for a move, 1 for a line, 2 and 3 for Bézier curves
+    uint32_t order;
+    float length;
+    // x and y of the first order + 1 points
+    float points[8];
+  };
+
+  // Views a pack in place, copying it only if it isn't suitably aligned. An
+  // invalid pack is treated as empty
+  OutlinePack(const void* data, size_t size);
+  // The pack generated for the bundled fonts at build time
+  static const OutlinePack& getBundled();
+
+  const Face* findFace(std::string_view face_name) const;
+  // Whether every character of text has an outline in the face
+  bool covers(const Face& face, std::string_view text) const;
+
+  inline const Glyph& glyph(const Face& face, char c) const {
+    return m_glyphs[face.first_glyph + static_cast<unsigned char>(c)];
+  }
+  inline std::span<const Segment> segments(const Glyph& glyph) const {
+    return m_segments.subspan(glyph.first_segment, glyph.num_segments);
+  }
+
+private:
+  std::vector<uint32_t> m_aligned_copy;
+  std::span<const Face> m_faces;
+  std::span<const Glyph> m_glyphs;
+  std::span<const Segment> m_segments;
+};
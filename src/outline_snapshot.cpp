@@ -0,0 +1,52 @@
+#include "outline_snapshot.h"
+
+#include <algorithm>
+
+size_t OutlineData::bytes() const {
+  return sizeof(OutlineData) + outline.bytes() +
+         samples.capacity() * sizeof(glm::vec2);
+}
+
+OutlineSnapshotStore::Reader::Reader(OutlineSnapshotStore& store)
+    : m_store(store) {
+  const std::lock_guard lock(m_store.m_mutex);
+  m_store.m_readers.push_back(this);
+}
+
+OutlineSnapshotStore::Reader::~Reader() {
+  const std::lock_guard lock(m_store.m_mutex);
+  std::erase(m_store.m_readers, this);
+}
+
+const OutlineSnapshot* OutlineSnapshotStore::Reader::acquire() {
+  // Pin, then check the snapshot is still the latest. If it is, publish()
+  // will see the pin before it decides whether to free it. Sequentially
+  // consistent ordering is needed so the pin and the publisher's store of
+  // the new latest can't both be missed
+  auto* snapshot = m_store.m_latest.load();
+  while (true) {
+    m_pinned.store(snapshot);
+    auto* latest = m_store.m_latest.load();
+    if (latest == snapshot) {
+      return snapshot;
+    }
+    snapshot = latest;
+  }
+}
+
+void OutlineSnapshotStore::publish(
+    std::unique_ptr<const OutlineSnapshot> snapshot) {
+  const std::lock_guard lock(m_mutex);
+  m_latest.store(snapshot.get());
+  m_num_published++;
+  m_pool.push_back(std::move(snapshot));
+  auto* latest = m_pool.back().get();
+  std::erase_if(m_pool, [this, latest](const auto& old) {
+    if (old.get() == latest) {
+      return false;
+    }
+    return std::none_of(m_readers.begin(), m_readers.end(), [&](auto* reader) {
+      return reader->m_pinned.load() == old.get();
+    });
+  });
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "outliner.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Stereo wavetable derived from an outline, with no DC component
+struct WavetableSamples {
+  static constexpr size_t s_num_samples = 512;
+
+  std::array<float, s_num_samples> ch0;
+  std::array<float, s_num_samples> ch1;
+};
+
+// Everything derived from one (face, text, pixel height). Never modified
+// once built, so it's shared between snapshots, and between plugin instances
+// through OutlineCache
+struct OutlineData {
+  // Kept for its arc-length tables. Empty if restored from saved state
+  Outline outline;
+  // Empty text has no outline, so the synth keeps its previous wavetable
+  bool has_wavetable = false;
+  WavetableSamples wavetable;
+  // Samples in outline coordinates. Empty if the text has no segments
+  std::vector<glm::vec2> samples;
+  BoundingBox bbox;
+  // Face metrics in pixels
+  float face_height = 0;
+  float descender = 0;
+  // Width of the last glyph, or of 'x' if the text is empty
+  float last_glyph_width = 0;
+
+  size_t bytes() const;
+};
+
+// One published outline. Never modified once published, so any thread can
+// read it without locking
+struct OutlineSnapshot {
+  // Increases with every request, so readers can tell whether it's changed
+  uint64_t version = 0;
+  std::string text;
+  std::string face_name;
+  std::shared_ptr<const OutlineData> data;
+};
+
+// Holds the latest OutlineSnapshot for readers on any thread, including the
+// audio thread. Each reader pins the snapshot it's using by writing it to a
+// slot that the publisher checks before freeing old snapshots. That keeps
+// acquiring lock-free and guarantees that frees only happen on the publisher
+// thread, which reference counting alone can't do
+class OutlineSnapshotStore {
+public:
+  class Reader {
+  public:
+    // Register and unregister off the audio thread, since they lock
+    explicit Reader(OutlineSnapshotStore& store);
+    ~Reader();
+    // Returns the latest snapshot, or nullptr if nothing has been published.
+    // Lock-free. The pointer stays valid until the next call or until the
+    // reader is destroyed
+    const OutlineSnapshot* acquire();
+
+  private:
+    friend class OutlineSnapshotStore;
+
+    OutlineSnapshotStore& m_store;
+    std::atomic<const OutlineSnapshot*> m_pinned = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE(Reader)
+  };
+
+  OutlineSnapshotStore() = default;
+  // Makes the snapshot the latest, then frees any older ones that no reader
+  // has pinned. Never call from the audio thread
+  void publish(std::unique_ptr<const OutlineSnapshot> snapshot);
+  // Number of snapshots published so far, so any thread can cheaply check
+  // for a new one without acquiring it
+  inline uint64_t getNumPublished() const { return m_num_published; }
+
+private:
+  // Guards the reader list and the pool, never taken by acquire()
+  std::mutex m_mutex;
+  std::vector<Reader*> m_readers;
+  // Owns the latest snapshot and any older ones still pinned
+  std::vector<std::unique_ptr<const OutlineSnapshot>> m_pool;
+  std::atomic<const OutlineSnapshot*> m_latest = nullptr;
+  std::atomic<uint64_t> m_num_published = 0;
+
+  JUCE_DECLARE_NON_COPYABLE(OutlineSnapshotStore)
+};
@@ -1,36 +1,34 @@
 #include "outliner.h"
 #include "error.h"
+#include "tracer.h"
 
 #include <freetype/ftbbox.h>
 #include <freetype/ftoutln.h>
 #include <glm/gtc/epsilon.hpp>
 #include <juce_core/juce_core.h>
+#include <algorithm>
 #include <optional>
 #include <sstream>
 #include <string>
 
 // Segment
-Segment::Segment(FT_Vector p0) : m_order(0) {
-  m_points.emplace_back(static_cast<float>(p0.x) / 64,
-                        static_cast<float>(p0.y) / 64);
+
+// Converts from 26.6 fixed point
+static glm::vec2 toPoint(FT_Vector v) {
+  return glm::vec2(static_cast<float>(v.x) / 64, static_cast<float>(v.y) / 64);
+}
+
+Segment::Segment(FT_Vector p0) : m_order(0), m_points{toPoint(p0)} {
   m_length = 0.0f;
 }
 
-Segment::Segment(FT_Vector p0, FT_Vector p1) : m_order(1) {
-  m_points.emplace_back(static_cast<float>(p0.x) / 64,
-                        static_cast<float>(p0.y) / 64);
-  m_points.emplace_back(static_cast<float>(p1.x) / 64,
-                        static_cast<float>(p1.y) / 64);
+Segment::Segment(FT_Vector p0, FT_Vector p1)
+    : m_order(1), m_points{toPoint(p0), toPoint(p1)} {
   m_length = glm::length(m_points[1] - m_points[0]);
 }
 
-Segment::Segment(FT_Vector p0, FT_Vector p1, FT_Vector p2) : m_order(2) {
-  m_points.emplace_back(static_cast<float>(p0.x) / 64,
-                        static_cast<float>(p0.y) / 64);
-  m_points.emplace_back(static_cast<float>(p1.x) / 64,
-                        static_cast<float>(p1.y) / 64);
-  m_points.emplace_back(static_cast<float>(p2.x) / 64,
-                        static_cast<float>(p2.y) / 64);
+Segment::Segment(FT_Vector p0, FT_Vector p1, FT_Vector p2)
+    : m_order(2), m_points{toPoint(p0), toPoint(p1), toPoint(p2)} {
   glm::vec2 prev = m_points[0];
   glm::vec2 curr;
   m_length = 0.0f;
@@ -43,15 +41,8 @@ Segment::Segment(FT_Vector p0, FT_Vector p1, FT_Vector p2) : m_order(2) {
 }
 
 Segment::Segment(FT_Vector p0, FT_Vector p1, FT_Vector p2, FT_Vector p3)
-    : m_order(3) {
-  m_points.emplace_back(static_cast<float>(p0.x) / 64,
-                        static_cast<float>(p0.y) / 64);
-  m_points.emplace_back(static_cast<float>(p1.x) / 64,
-                        static_cast<float>(p1.y) / 64);
-  m_points.emplace_back(static_cast<float>(p2.x) / 64,
-                        static_cast<float>(p2.y) / 64);
-  m_points.emplace_back(static_cast<float>(p3.x) / 64,
-                        static_cast<float>(p3.y) / 64);
+    : m_order(3),
+      m_points{toPoint(p0), toPoint(p1), toPoint(p2), toPoint(p3)} {
   glm::vec2 prev = m_points[0];
   glm::vec2 curr;
   m_length = 0.0f;
@@ -63,11 +54,17 @@ Segment::Segment(FT_Vector p0, FT_Vector p1, FT_Vector p2, FT_Vector p3)
   }
 }
 
+Segment::Segment(size_t order, std::span<const glm::vec2> points,
+                 float length)
+    : m_length(length), m_order(order), m_points{} {
+  std::copy_n(points.begin(), order + 1, m_points.begin());
+}
+
 bool Segment::operator==(const Segment& other) const {
   if (m_order != other.m_order) {
     return false;
   } else {
-    for (size_t i = 0; i < m_points.size(); i++) {
+    for (size_t i = 0; i <= m_order; i++) {
       if (!glm::all(glm::epsilonEqual(m_points[i], other.m_points[i],
                                       std::numeric_limits<float>::epsilon()))) {
         return false;
@@ -135,7 +132,7 @@ glm::vec2 Segment::sample(float t) const {
 }
 
 void Segment::flip(float y_min, float y_max) {
-  for (auto& point : m_points) {
+  for (auto& point : std::span(m_points).first(m_order + 1)) {
     point.y = y_max - (point.y - y_min);
   }
 }
@@ -185,7 +182,7 @@ float BoundingBox::height() const { return max.y - min.y; }
 // Outline
 
 struct UserData {
-  FT_Vector& pen;
+  FT_Vector pen;
   std::vector<Segment>& segments;
   std::optional<FT_Vector> p0;
 };
@@ -239,16 +236,24 @@ FT_Outline_Funcs funcs = {
 
 Outline::Outline() : m_text("") {}
 
+void Outline::decompose(FT_Outline& outline, FT_Vector pen,
+                        std::vector<Segment>& segments) {
+  UserData user = {
+      .pen = pen,
+      .segments = segments,
+      .p0 = std::nullopt,
+  };
+  if (auto err = FT_Outline_Decompose(&outline, &funcs, &user)) {
+    throw FreetypeError(FT_Error_String(err));
+  }
+}
+
 Outline::Outline(std::string_view text, FT_Face face, FT_UInt pixel_height,
                  bool invert_y, size_t num_param_samples)
     : m_text(text), m_num_param_samples(num_param_samples) {
+  GLYNTH_TRACE_SCOPE("Outline::Outline");
   FT_Error err;
   FT_Vector pen{.x = 0, .y = 0};
-  UserData user = {
-      .pen = pen,
-      .segments = m_segments,
-      .p0 = std::nullopt,
-  };
 
   if ((err = FT_Set_Pixel_Sizes(face, 0, pixel_height))) {
     throw FreetypeError(FT_Error_String(err));
@@ -266,9 +271,7 @@ Outline::Outline(std::string_view text, FT_Face face, FT_UInt pixel_height,
           fmt::format("(Glyph for '{}' was not an outline)", text[i]));
     }
 
-    if ((err = FT_Outline_Decompose(&glyph->outline, &funcs, &user))) {
-      throw FreetypeError(FT_Error_String(err));
-    }
+    decompose(glyph->outline, pen, m_segments);
 
     FT_BBox bbox;
     if ((err = FT_Outline_Get_BBox(&glyph->outline, &bbox))) {
@@ -290,10 +293,48 @@ Outline::Outline(std::string_view text, FT_Face face, FT_UInt pixel_height,
     }
   }
 
+  buildArcLengthTables();
+}
+
+Outline::Outline(std::string_view text, const OutlinePack& pack,
+                 const OutlinePack::Face& face, FT_UInt pixel_height,
+                 size_t num_param_samples)
+    : m_text(text), m_num_param_samples(num_param_samples) {
+  GLYNTH_TRACE_SCOPE("Outline::Outline (pack)");
+  // Same scale as FT_Set_Pixel_Sizes, though without hinting
+  float scale = static_cast<float>(pixel_height) / face.units_per_em;
+  glm::vec2 pen(0);
+  std::array<glm::vec2, 4> points;
+  for (char c : text) {
+    auto& glyph = pack.glyph(face, c);
+    for (auto& segment : pack.segments(glyph)) {
+      for (size_t k = 0; k <= segment.order; k++) {
+        glm::vec2 point(segment.points[2 * k], segment.points[2 * k + 1]);
+        points[k] = point * scale + pen;
+      }
+      m_segments.emplace_back(segment.order, points, segment.length * scale);
+    }
+    BoundingBox bbox;
+    bbox.min = glm::vec2(glyph.min_x, glyph.min_y) * scale + pen;
+    bbox.max = glm::vec2(glyph.max_x, glyph.max_y) * scale + pen;
+    m_bbox.expand(bbox);
+    pen.x += glyph.advance * scale;
+  }
+  buildArcLengthTables();
+}
+
+void Outline::buildArcLengthTables() {
   if (m_segments.size() == 0) {
     return;
   }
 
+  // Distance to the start of each segment
+  std::vector<float> starts(m_segments.size());
+  float distance = 0.0f;
+  for (size_t k = 0; k < m_segments.size(); k++) {
+    starts[k] = distance;
+    distance += m_segments[k].length();
+  }
   // See https://pomax.github.io/bezierinfo/#tracing
   m_parameters.resize(m_num_param_samples);
   m_distances.resize(m_num_param_samples, 0.0f);
@@ -304,13 +345,9 @@ Outline::Outline(std::string_view text, FT_Face face, FT_UInt pixel_height,
     m_parameters[i] = std::min(m_parameters[i], std::nextafter(1.0f, 0.0f));
     float j_decimal = m_parameters[i] * static_cast<float>(m_segments.size());
     size_t j = static_cast<size_t>(j_decimal);
-    // Add length of all segments coming before segment j
-    for (size_t k = 0; k < j; k++) {
-      m_distances[i] += m_segments[k].length();
-    }
     // Add length of the part of segment j included by parameter
     float j_whole = static_cast<float>(j);
-    m_distances[i] += m_segments[j].length(j_decimal - j_whole);
+    m_distances[i] = starts[j] + m_segments[j].length(j_decimal - j_whole);
   }
 }
 
@@ -380,3 +417,11 @@ std::string Outline::svg_str() const {
   }
   return ss.str();
 }
+
+size_t Outline::bytes() const {
+  size_t total = sizeof(Outline) + m_text.capacity();
+  total += m_segments.capacity() * sizeof(Segment);
+  total += m_parameters.capacity() * sizeof(float);
+  total += m_distances.capacity() * sizeof(float);
+  return total;
+}
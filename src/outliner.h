@@ -1,5 +1,8 @@
 #pragma once
 
+#include "outline_pack.h"
+
+#include <array>
 #include <fmt/base.h>
 #include <fmt/format.h>
 #include <freetype/freetype.h>
@@ -13,6 +16,8 @@ struct Segment {
   Segment(FT_Vector p0, FT_Vector p1);
   Segment(FT_Vector p0, FT_Vector p1, FT_Vector p2);
   Segment(FT_Vector p0, FT_Vector p1, FT_Vector p2, FT_Vector p3);
+  // Copies the first order + 1 points, with the length already known
+  Segment(size_t order, std::span<const glm::vec2> points, float length);
 
   bool operator==(const Segment& other) const;
 
@@ -20,11 +25,16 @@ struct Segment {
   glm::vec2 sample(float t) const;
   void flip(float y_min, float y_max);
   std::string svg_str() const;
+  inline size_t order() const { return m_order; }
+  inline std::span<const glm::vec2> points() const {
+    return std::span(m_points).first(m_order + 1);
+  }
 
 private:
   float m_length;
   size_t m_order;
-  std::vector<glm::vec2> m_points;
+  // Only the first m_order + 1 are used
+  std::array<glm::vec2, 4> m_points;
 };
 
 struct BoundingBox {
@@ -42,9 +52,19 @@ public:
   Outline(); // Empty
   Outline(std::string_view text, FT_Face face, FT_UInt pixel_height,
           bool invert_y = false, size_t arc_length_samples = 10000);
+  // Assembles the outline from precomputed glyphs, without FreeType. The
+  // pack must cover the text
+  Outline(std::string_view text, const OutlinePack& pack,
+          const OutlinePack::Face& face, FT_UInt pixel_height,
+          size_t arc_length_samples = 10000);
 
   bool operator==(const Outline& other) const;
 
+  // Appends the segments of one glyph, offset by the pen. Coordinates are
+  // taken as 26.6 fixed point
+  static void decompose(FT_Outline& outline, FT_Vector pen,
+                        std::vector<Segment>& segments);
+
   const std::span<const Segment> segments() const;
   const BoundingBox& bbox() const;
   std::string_view text() const;
@@ -52,8 +72,12 @@ public:
   // Note: expects the parameter values to be increasing
   std::vector<glm::vec2> sample(std::span<float> t) const;
   std::string svg_str() const;
+  // Approximate memory used, including the arc-length tables
+  size_t bytes() const;
 
 private:
+  void buildArcLengthTables();
+
   std::string m_text;
   std::vector<Segment> m_segments;
   BoundingBox m_bbox;
@@ -0,0 +1,226 @@
+#include "plugin_state.h"
+#include "error.h"
+#include "outline_builder.h"
+
+#include <array>
+#include <fmt/format.h>
+#include <optional>
+
+namespace {
+
+constexpr int32_t fourcc(const char (&id)[5]) {
+  return static_cast<int32_t>(static_cast<uint32_t>(id[0]) |
+                              static_cast<uint32_t>(id[1]) << 8 |
+                              static_cast<uint32_t>(id[2]) << 16 |
+                              static_cast<uint32_t>(id[3]) << 24);
+}
+
+constexpr int32_t s_magic = fourcc("GLYN");
+constexpr int32_t s_params_id = fourcc("PARM");
+constexpr int32_t s_outline_id = fourcc("OUTL");
+constexpr int32_t s_wavetable_id = fourcc("WAVE");
+// Bump whenever building an outline or wavetable changes, so saved ones get
+// rebuilt instead of restored
+constexpr uint64_t s_outline_revision = 2;
+
+// Filter parameters in the order they were saved before versioning
+constexpr std::array<std::string_view, 4> s_legacy_params = {
+    "hpf_freq", "hpf_res", "lpf_freq", "lpf_res"};
+
+void writeChunk(juce::MemoryOutputStream& stream, int32_t id,
+                const juce::MemoryOutputStream& chunk) {
+  stream.writeInt(id);
+  stream.writeInt(static_cast<int>(chunk.getDataSize()));
+  stream.write(chunk.getData(), chunk.getDataSize());
+}
+
+// Floats are copied as-is, which assumes a little-endian host like the
+// stream's integers
+template <typename T>
+void writeRaw(juce::MemoryOutputStream& stream, const T* data, size_t count) {
+  stream.write(data, count * sizeof(T));
+}
+
+template <typename T>
+void readRaw(juce::MemoryInputStream& stream, T* data, size_t count) {
+  auto bytes = static_cast<int>(count * sizeof(T));
+  if (stream.read(data, bytes) != bytes) {
+    throw GlynthError("Truncated state chunk");
+  }
+}
+
+void writeOutlineData(juce::MemoryOutputStream& stream,
+                      const OutlineData& data) {
+  auto& wavetable = data.wavetable;
+  stream.writeInt(static_cast<int>(WavetableSamples::s_num_samples));
+  writeRaw(stream, wavetable.ch0.data(), wavetable.ch0.size());
+  writeRaw(stream, wavetable.ch1.data(), wavetable.ch1.size());
+  stream.writeFloat(data.bbox.min.x);
+  stream.writeFloat(data.bbox.min.y);
+  stream.writeFloat(data.bbox.max.x);
+  stream.writeFloat(data.bbox.max.y);
+  stream.writeFloat(data.face_height);
+  stream.writeFloat(data.descender);
+  stream.writeFloat(data.last_glyph_width);
+  stream.writeInt(static_cast<int>(data.samples.size()));
+  writeRaw(stream, data.samples.data(), data.samples.size());
+}
+
+// Returns nullptr if the saved sizes don't match this build, or if the data
+// would run past end, the end of its chunk
+std::shared_ptr<const OutlineData>
+readOutlineData(juce::MemoryInputStream& stream, juce::int64 end) {
+  auto fits = [&](size_t bytes) {
+    return static_cast<juce::int64>(bytes) <= end - stream.getPosition();
+  };
+  auto data = std::make_shared<OutlineData>();
+  auto num_samples = static_cast<size_t>(stream.readInt());
+  if (num_samples != WavetableSamples::s_num_samples) {
+    return nullptr;
+  }
+  // Both channels, then the bounding box, metrics and preview count
+  if (!fits(2 * num_samples * sizeof(float) + 8 * sizeof(float))) {
+    return nullptr;
+  }
+  readRaw(stream, data->wavetable.ch0.data(), num_samples);
+  readRaw(stream, data->wavetable.ch1.data(), num_samples);
+  data->has_wavetable = true;
+  data->bbox.min.x = stream.readFloat();
+  data->bbox.min.y = stream.readFloat();
+  data->bbox.max.x = stream.readFloat();
+  data->bbox.max.y = stream.readFloat();
+  data->face_height = stream.readFloat();
+  data->descender = stream.readFloat();
+  data->last_glyph_width = stream.readFloat();
+  auto num_preview_samples = static_cast<size_t>(stream.readInt());
+  if (num_preview_samples != OutlineBuilder::s_num_preview_samples &&
+      num_preview_samples != 0) {
+    return nullptr;
+  }
+  if (!fits(num_preview_samples * sizeof(glm::vec2))) {
+    return nullptr;
+  }
+  data->samples.resize(num_preview_samples);
+  readRaw(stream, data->samples.data(), num_preview_samples);
+  return data;
+}
+
+PluginState readLegacy(juce::MemoryInputStream& stream) {
+  PluginState state;
+  for (auto id : s_legacy_params) {
+    state.params.push_back({std::string(id), stream.readFloat()});
+  }
+  state.outline_text = stream.readString().toStdString();
+  state.outline_face = stream.readString().toStdString();
+  return state;
+}
+
+} // namespace
+
+void PluginState::write(juce::MemoryBlock& dest_data) const {
+  auto stream = juce::MemoryOutputStream(dest_data, true);
+  stream.writeInt(s_magic);
+  stream.writeInt(s_version);
+
+  juce::MemoryOutputStream params_chunk;
+  params_chunk.writeInt(static_cast<int>(params.size()));
+  for (auto& param : params) {
+    params_chunk.writeString(param.id);
+    params_chunk.writeFloat(param.value);
+  }
+  writeChunk(stream, s_params_id, params_chunk);
+
+  juce::MemoryOutputStream outline_chunk;
+  outline_chunk.writeString(outline_text);
+  outline_chunk.writeString(outline_face);
+  writeChunk(stream, s_outline_id, outline_chunk);
+
+  if (outline_data != nullptr) {
+    juce::MemoryOutputStream wavetable_chunk;
+    wavetable_chunk.writeInt64(static_cast<juce::int64>(
+        hashOutline(outline_face, outline_text)));
+    writeOutlineData(wavetable_chunk, *outline_data);
+    writeChunk(stream, s_wavetable_id, wavetable_chunk);
+  }
+}
+
+PluginState PluginState::read(const void* data, size_t size) {
+  auto stream = juce::MemoryInputStream(data, size, false);
+  if (size == 0) {
+    return {};
+  }
+  if (size < 8 || stream.readInt() != s_magic) {
+    stream.setPosition(0);
+    return readLegacy(stream);
+  }
+  // Newer versions only add chunks, so there's nothing to check yet
+  stream.readInt();
+
+  PluginState state;
+  std::optional<uint64_t> saved_hash;
+  std::shared_ptr<const OutlineData> saved_data;
+  while (stream.getNumBytesRemaining() >= 8) {
+    auto id = stream.readInt();
+    auto chunk_size = stream.readInt();
+    auto end = stream.getPosition() + chunk_size;
+    if (chunk_size < 0 || end > static_cast<juce::int64>(size)) {
+      throw GlynthError(fmt::format("Bad size {} for state chunk {:#x}",
+                                    chunk_size, static_cast<uint32_t>(id)));
+    }
+    if (id == s_params_id) {
+      int count = stream.readInt();
+      for (int i = 0; i < count && stream.getPosition() < end; i++) {
+        auto param_id = stream.readString().toStdString();
+        state.params.push_back({param_id, stream.readFloat()});
+      }
+      if (stream.getPosition() > end && !state.params.empty()) {
+        // The last entry ran into whatever follows the chunk
+        state.params.pop_back();
+      }
+    } else if (id == s_outline_id) {
+      state.outline_text = stream.readString().toStdString();
+      state.outline_face = stream.readString().toStdString();
+    } else if (id == s_wavetable_id) {
+      saved_hash = static_cast<uint64_t>(stream.readInt64());
+      saved_data = readOutlineData(stream, end);
+      if (stream.getPosition() > end) {
+        // Damaged, so the outline is rebuilt rather than restored
+        saved_data = nullptr;
+      }
+    }
+    // Skips unknown chunks and anything a known chunk gained since
+    stream.setPosition(end);
+  }
+  if (saved_hash == hashOutline(state.outline_face, state.outline_text)) {
+    state.outline_data = std::move(saved_data);
+  }
+  return state;
+}
+
+uint64_t PluginState::hashOutline(std::string_view face_name,
+                                  std::string_view text) {
+  // 64-bit FNV-1a
+  uint64_t hash = 0xcbf29ce484222325;
+  auto add = [&hash](const void* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      hash ^= static_cast<const uint8_t*>(data)[i];
+      hash *= 0x100000001b3;
+    }
+  };
+  auto add_string = [&add](std::string_view s) {
+    add(s.data(), s.size());
+    // Keeps ("ab", "c") and ("a", "bc") apart
+    add("", 1);
+  };
+  add_string(face_name);
+  add_string(text);
+  auto pixel_height = static_cast<uint64_t>(OutlineBuilder::s_pixel_height);
+  auto num_samples = static_cast<uint64_t>(WavetableSamples::s_num_samples);
+  auto num_preview_samples =
+      static_cast<uint64_t>(OutlineBuilder::s_num_preview_samples);
+  add(&pixel_height, sizeof(pixel_height));
+  add(&num_samples, sizeof(num_samples));
+  add(&num_preview_samples, sizeof(num_preview_samples));
+  add(&s_outline_revision, sizeof(s_outline_revision));
+  return hash;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "outline_snapshot.h"
+
+#include <cstdint>
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Everything saved with a session, in a versioned format of tagged chunks:
+//
+//   "GLYN" version
+//   "PARM" size  count (id value)...
+//   "OUTL" size  text face
+//   "WAVE" size  hash wavetable preview
+//
+// Readers skip chunks they don't know, so chunks can be added without
+// bumping the version. The wavetable and preview are saved so a session can
+// be restored without touching FreeType, as long as the hash still matches
+// what would be built. State saved before versioning (four filter floats and
+// the outline strings) is still read
+struct PluginState {
+  static constexpr int32_t s_version = 1;
+
+  struct Param {
+    std::string id;
+    float value;
+  };
+
+  std::vector<Param> params;
+  std::string outline_text;
+  std::string outline_face;
+  // Built outline for outline_text and outline_face, or nullptr if the
+  // state didn't include one or it's stale
+  std::shared_ptr<const OutlineData> outline_data;
+
+  void write(juce::MemoryBlock& dest_data) const;
+  // Throws GlynthError if the data is malformed
+  static PluginState read(const void* data, size_t size);
+  // Stable across runs and platforms, unlike std::hash. Changes whenever the
+  // built outline would, including when the build itself changes
+  static uint64_t hashOutline(std::string_view face_name,
+                              std::string_view text);
+};
@@ -2,10 +2,13 @@
 #include "editor.h"
 #include "error.h"
 #include "logger.h"
+#include "plugin_state.h"
 
+#include <bit>
 #include <fmt/format.h>
 #include <npy/npy.h>
 #include <npy/tensor.h>
+#include <random>
 
 GlynthProcessor::GlynthProcessor()
     : AudioProcessor(s_io_layouts),
@@ -33,34 +36,57 @@ GlynthProcessor::GlynthProcessor()
           juce::ParameterID("decay", 1), "Decay (Env)",
           juce::NormalisableRange(0.0f, 10000.0f, 1e-4f, 0.15f), 100.0f,
           juce::AudioParameterFloatAttributes().withLabel("ms")))),
+      m_noise_level(*(new juce::AudioParameterFloat(
+          juce::ParameterID("noise_level", 1), "Level (Noise)",
+          juce::NormalisableRange(0.0f, 1.0f), 0.0f,
+          juce::AudioParameterFloatAttributes().withLabel("")))),
+      m_noise_color(*(new juce::AudioParameterChoice(
+          juce::ParameterID("noise_color", 1), "Color (Noise)",
+          juce::StringArray{"White", "Pink"}, 0))),
+      m_state_reader(m_outline_snapshots),
       m_synth(*(new Synth(*this, m_attack_ms, m_decay_ms))),
       m_trigger_handler_x(*(new TriggerHandler(*this, 0))),
-      m_trigger_handler_y(*(new TriggerHandler(*this, 1))) {
-#ifdef GLYNTH_LOG_TO_FILE
+      m_trigger_handler_y(*(new TriggerHandler(*this, 1))),
+      m_xy_tap(*(new XYTap(*this))),
+      m_silencer(*(new CorruptionSilencer(*this))),
+      m_outline_builder(m_outline_snapshots) {
+  // Logs warnings raised on the audio thread
   startTimerHz(1);
-#endif
   addParameter(&m_hpf_freq);
   addParameter(&m_hpf_res);
   addParameter(&m_lpf_freq);
   addParameter(&m_lpf_res);
   addParameter(&m_attack_ms);
   addParameter(&m_decay_ms);
+  addParameter(&m_noise_level);
+  addParameter(&m_noise_color);
 
   m_processors.emplace_back(&m_synth);
+  m_processors.emplace_back(
+      new NoiseGenerator(*this, &m_noise_level, &m_noise_color));
   m_processors.emplace_back(new HighPassFilter(*this, &m_hpf_freq, &m_hpf_res));
   m_processors.emplace_back(new LowPassFilter(*this, &m_lpf_freq, &m_lpf_res));
-  m_processors.emplace_back(new CorruptionSilencer(*this));
+  m_processors.emplace_back(&m_silencer);
   m_processors.emplace_back(&m_trigger_handler_x);
   m_processors.emplace_back(&m_trigger_handler_y);
+  m_processors.emplace_back(&m_xy_tap);
+#ifdef GLYNTH_LOAD_METER
+  std::vector<std::string> stage_names;
+  for (auto& processor : m_processors) {
+    stage_names.emplace_back(processor->getName());
+  }
+  m_load_meter = std::make_unique<LoadMeter>(std::move(stage_names));
+#endif
 
-  m_font_manager.addFace("SplineSansMono-Bold");
-  m_font_manager.addFace("SplineSansMono-Medium");
-  auto face = m_font_manager.getFace(m_outline_face);
-  m_outline = Outline(m_outline_text, face, 20);
-  m_synth.updateWavetable(m_outline);
+  // Hosts construct plugins while scanning and loading sessions, so the
+  // default outline is built on the worker instead. The synth is silent
+  // until it's ready, then crossfades in. A state restore before then just
+  // replaces the request
+  m_outline_builder.request(m_outline_text, m_outline_face);
 }
 
-GlynthProcessor::~GlynthProcessor() { fclose(Logger::file); }
+// The log file is shared by every instance, so it stays open
+GlynthProcessor::~GlynthProcessor() { fflush(Logger::file); }
 
 void GlynthProcessor::prepareToPlay(double sample_rate, int samples_per_block) {
   fmt::println(Logger::file,
@@ -72,6 +98,9 @@ void GlynthProcessor::prepareToPlay(double sample_rate, int samples_per_block) {
   for (auto& processor : m_processors) {
     processor->prepareToPlay(sample_rate, samples_per_block);
   }
+#ifdef GLYNTH_LOAD_METER
+  m_load_meter->prepareToPlay(sample_rate, samples_per_block);
+#endif
 }
 
 void GlynthProcessor::releaseResources() {
@@ -87,66 +116,100 @@ bool GlynthProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const {
 void GlynthProcessor::processBlock(juce::AudioBuffer<float>& buffer,
                                    juce::MidiBuffer& midi_messages) {
   // Normal process block
+  GLYNTH_RT_SCOPE();
+  GLYNTH_TRACE_THREAD("Audio");
+  GLYNTH_TRACE_SCOPE("processBlock");
   juce::ScopedNoDenormals noDenormals;
+#ifdef GLYNTH_LOAD_METER
+  auto block_start = LoadMeter::now();
+#endif
   for (int ch = 0; ch < getTotalNumOutputChannels(); ch++) {
     // Clear unused output buffers to avoid garbage data blasting speakers
     buffer.clear(ch, 0, buffer.getNumSamples());
   }
 
+#ifdef GLYNTH_LOAD_METER
+  auto stage_start = LoadMeter::now();
+  for (size_t i = 0; i < m_processors.size(); i++) {
+    m_processors[i]->processBlock(buffer, midi_messages);
+    auto stage_end = LoadMeter::now();
+    m_load_meter->record(i, stage_end - stage_start);
+    stage_start = stage_end;
+  }
+  m_load_meter->endBlock(stage_start - block_start);
+#else
   for (auto& processor : m_processors) {
     processor->processBlock(buffer, midi_messages);
   }
+#endif
 }
 
 juce::AudioProcessorEditor* GlynthProcessor::createEditor() {
   // return new juce::GenericAudioProcessorEditor(*this);
-  return new GlynthEditor(*this, m_font_manager);
+  return new GlynthEditor(*this);
 }
 
 void GlynthProcessor::getStateInformation(juce::MemoryBlock& dest_data) {
-  // Stores parameters in the memory block, either as raw data or using the
-  // XML or ValueTree classes as intermediaries to make it easy to save and load
-  // complex data.
-  auto stream = juce::MemoryOutputStream(dest_data, true);
-  stream.writeFloat(m_hpf_freq);
-  stream.writeFloat(m_hpf_res);
-  stream.writeFloat(m_lpf_freq);
-  stream.writeFloat(m_lpf_res);
-  stream.writeString(m_outline_text);
-  stream.writeString(m_outline_face);
+  PluginState state;
+  for (auto* param : getParams()) {
+    state.params.push_back({param->paramID.toStdString(),
+                            param->convertFrom0to1(param->getValue())});
+  }
+  state.outline_text = m_outline_text;
+  state.outline_face = m_outline_face;
+  {
+    // Only saved if it's been built, so a load can skip FreeType
+    const std::lock_guard lock(m_state_mutex);
+    auto* outline = m_state_reader.acquire();
+    if (outline != nullptr && outline->text == m_outline_text &&
+        outline->face_name == m_outline_face &&
+        outline->data->has_wavetable) {
+      state.outline_data = outline->data;
+    }
+  }
+  state.write(dest_data);
 }
 
 void GlynthProcessor::setStateInformation(const void* data, int size) {
-  // Restore parameters from this memory block, whose contents will have been
-  // created by the getStateInformation() call.
-  auto stream = juce::MemoryInputStream(data, static_cast<size_t>(size), false);
-  m_hpf_freq = stream.readFloat();
-  m_hpf_res = stream.readFloat();
-  m_lpf_freq = stream.readFloat();
-  m_lpf_res = stream.readFloat();
-  std::string outline_text = stream.readString().toStdString();
-  std::string outline_face = stream.readString().toStdString();
-  if (outline_text != "" && outline_face != "") {
-    m_outline_text = outline_text;
-    m_outline_face = outline_face;
-    auto face = m_font_manager.getFace(m_outline_face);
-    m_outline = Outline(m_outline_text, face, 20);
-    m_synth.updateWavetable(m_outline);
+  PluginState state;
+  try {
+    state = PluginState::read(data, static_cast<size_t>(size));
+  } catch (const GlynthError& e) {
+    fmt::println(Logger::file, "Unable to restore state: {}", e.what());
+    return;
+  }
+  for (auto& [id, value] : state.params) {
+    for (auto* param : getParams()) {
+      // Parameters that no longer exist are ignored
+      if (param->paramID.toStdString() == id) {
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+      }
+    }
+  }
+  if (state.outline_text != "" && state.outline_face != "") {
+    m_outline_text = state.outline_text;
+    m_outline_face = state.outline_face;
+    if (state.outline_data != nullptr) {
+      m_outline_builder.restore(m_outline_text, m_outline_face,
+                                std::move(state.outline_data));
+    } else {
+      m_outline_builder.request(m_outline_text, m_outline_face);
+    }
   }
 }
 
 void GlynthProcessor::timerCallback() {
+  m_silencer.logWarnings();
 #ifdef GLYNTH_LOG_TO_FILE
   fflush(Logger::file);
 #endif
 }
 
 juce::AudioParameterFloat& GlynthProcessor::getParamById(std::string_view id) {
-  auto params = {&m_hpf_freq, &m_hpf_res,   &m_lpf_freq,
-                 &m_lpf_res,  &m_attack_ms, &m_decay_ms};
-  for (juce::AudioParameterFloat* param : params) {
-    if (id == param->paramID.toStdString()) {
-      return *param;
+  for (juce::RangedAudioParameter* param : getParams()) {
+    auto* float_param = dynamic_cast<juce::AudioParameterFloat*>(param);
+    if (float_param != nullptr && id == param->paramID.toStdString()) {
+      return *float_param;
     }
   }
   // Should be unreachable
@@ -155,25 +218,34 @@ juce::AudioParameterFloat& GlynthProcessor::getParamById(std::string_view id) {
 
 void GlynthProcessor::setOutlineFace(std::string_view face_name) {
   m_outline_face = face_name;
-  auto face = m_font_manager.getFace(face_name);
-  m_outline = Outline(m_outline_text, face, 20);
-  m_synth.updateWavetable(m_outline);
+  m_outline_builder.request(m_outline_text, m_outline_face);
 }
 
 void GlynthProcessor::setOutlineText(std::string_view outline_text) {
-  m_outline_text = outline_text;
-  auto face = m_font_manager.getFace(m_outline_face);
-  m_outline = Outline(outline_text, face, 20);
-  m_synth.updateWavetable(m_outline);
+  // Empty text only updates the preview, so the synth and saved state keep
+  // the last outline
+  if (outline_text != "") {
+    m_outline_text = outline_text;
+  }
+  m_outline_builder.request(outline_text, m_outline_face);
 }
 
-const Outline& GlynthProcessor::getOutline() { return m_outline; }
+std::string_view GlynthProcessor::getOutlineText() { return m_outline_text; }
+
+std::string_view GlynthProcessor::getOutlineFace() { return m_outline_face; }
 
-FT_Face GlynthProcessor::getOutlineFace() {
-  return m_font_manager.getFace(m_outline_face);
+bool GlynthProcessor::waitForOutline(int timeout_ms) {
+  return m_outline_builder.waitUntilIdle(timeout_ms);
 }
 
-std::string_view GlynthProcessor::getOutlineText() { return m_outline_text; }
+std::array<juce::RangedAudioParameter*, 8> GlynthProcessor::getParams() {
+  return {&m_hpf_freq,  &m_hpf_res,  &m_lpf_freq,    &m_lpf_res,
+          &m_attack_ms, &m_decay_ms, &m_noise_level, &m_noise_color};
+}
+
+OutlineSnapshotStore& GlynthProcessor::getOutlineSnapshots() {
+  return m_outline_snapshots;
+}
 
 TriggerHandler& GlynthProcessor::getTriggerHandler(int channel) {
   if (channel == 0) {
@@ -185,6 +257,12 @@ TriggerHandler& GlynthProcessor::getTriggerHandler(int channel) {
   }
 }
 
+XYTap& GlynthProcessor::getXYTap() { return m_xy_tap; }
+
+#ifdef GLYNTH_LOAD_METER
+const LoadMeter& GlynthProcessor::getLoadMeter() const { return *m_load_meter; }
+#endif
+
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() {
   return new GlynthProcessor();
 }
@@ -197,55 +275,145 @@ CorruptionSilencer::CorruptionSilencer(GlynthProcessor& processor_ref)
 
 void CorruptionSilencer::processBlock(juce::AudioBuffer<float>& buffer,
                                       juce::MidiBuffer&) {
-  // Check output for earrape and silence buffer if present
-  bool warned = false;
-  for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
+  // Check output for earrape and silence buffer if present. Problems are
+  // only flagged here and logged later by logWarnings()
+  uint8_t warnings = 0;
+  bool should_silence = false;
+  for (int ch = 0; ch < buffer.getNumChannels() && !should_silence; ch++) {
     auto samples = buffer.getWritePointer(ch);
     for (int i = 0; i < buffer.getNumSamples(); i++) {
       float x = samples[i];
-      bool should_silence = false;
       if (std::isnan(x) || std::isinf(x)) {
+        warnings |= s_non_finite;
         should_silence = true;
-        if (!warned) {
-          fmt::println(Logger::file,
-                       "Warning: audio buffer contains inf or nan");
-          warned = true;
-        }
+        break;
       } else if (std::abs(x) > 2.0f) {
+        warnings |= s_out_of_range;
         should_silence = true;
-        if (!warned) {
-          fmt::println(Logger::file,
-                       "Warning: sample significantly out of range");
-          warned = true;
-        }
+        break;
       } else if (std::abs(x) > 1.0f) {
         samples[i] = std::clamp(x, -1.0f, 1.0f);
-        if (!warned) {
-          fmt::println(Logger::file, "Warning: clamped out of range sample");
-          warned = true;
-        }
+        warnings |= s_clamped;
       }
+    }
+  }
 
-      if (should_silence) {
-        buffer.clear();
-        return;
-      }
+  if (should_silence) {
+    buffer.clear();
+  }
+  if (warnings != 0) {
+    m_warnings.fetch_or(warnings, std::memory_order_relaxed);
+  }
+}
+
+void CorruptionSilencer::logWarnings() {
+  auto warnings = m_warnings.exchange(0, std::memory_order_relaxed);
+  if (warnings & s_non_finite) {
+    fmt::println(Logger::file, "Warning: audio buffer contains inf or nan");
+  }
+  if (warnings & s_out_of_range) {
+    fmt::println(Logger::file, "Warning: sample significantly out of range");
+  }
+  if (warnings & s_clamped) {
+    fmt::println(Logger::file, "Warning: clamped out of range sample");
+  }
+}
+
+NoiseGenerator::NoiseGenerator(GlynthProcessor& processor_ref,
+                               juce::AudioParameterFloat* level_param,
+                               juce::AudioParameterChoice* color_param)
+    : SubProcessor(processor_ref), m_level_param(level_param),
+      m_color_param(color_param) {
+  // Seed every lane from a single random value using splitmix64, which is
+  // the seeding procedure recommended by the xoshiro authors
+  std::random_device rd;
+  uint64_t x = (static_cast<uint64_t>(rd()) << 32) | rd();
+  for (size_t k = 0; k < s_num_lanes; k++) {
+    for (auto& word : m_state) {
+      x += 0x9e3779b97f4a7c15;
+      uint64_t z = x;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      word[k] = static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
     }
   }
 }
 
-NoiseGenerator::NoiseGenerator(GlynthProcessor& processor_ref)
-    : SubProcessor(processor_ref), m_gen(m_rd()), m_dist(-0.5f, 0.5f) {}
+void NoiseGenerator::prepareToPlay(double, int samples_per_block) {
+  auto num_channels = m_processor_ref.getTotalNumOutputChannels();
+  m_pink_states.assign(static_cast<size_t>(num_channels), PinkState());
+  m_scratch.resize(static_cast<size_t>(samples_per_block));
+}
 
 void NoiseGenerator::processBlock(juce::AudioBuffer<float>& buffer,
                                   juce::MidiBuffer&) {
-  for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
-    for (int i = 0; i < buffer.getNumSamples(); i++) {
-      buffer.setSample(ch, i, m_dist(m_gen));
+  // Skipping entirely makes the generator free when it isn't being used
+  float level = m_level_param->get();
+  if (level <= 0.0f || m_scratch.empty()) {
+    return;
+  }
+
+  // Choice indices follow the order of Color
+  auto color = static_cast<Color>(m_color_param->getIndex());
+  if (color == Color::Pink) {
+    level *= s_pink_gain;
+  }
+
+  int num_channels =
+      std::min(buffer.getNumChannels(), static_cast<int>(m_pink_states.size()));
+  for (int ch = 0; ch < num_channels; ch++) {
+    auto& state = m_pink_states[static_cast<size_t>(ch)];
+    // Hosts may occasionally send more samples than promised, so work in
+    // chunks no larger than the scratch buffer
+    int start = 0;
+    while (start < buffer.getNumSamples()) {
+      int n = std::min(buffer.getNumSamples() - start,
+                       static_cast<int>(m_scratch.size()));
+      auto samples = std::span(m_scratch).first(static_cast<size_t>(n));
+      fill(samples);
+      if (color == Color::Pink) {
+        for (auto& x : samples) {
+          state.b0 = 0.99765f * state.b0 + x * 0.0990460f;
+          state.b1 = 0.96300f * state.b1 + x * 0.2965164f;
+          state.b2 = 0.57000f * state.b2 + x * 1.0526913f;
+          x = state.b0 + state.b1 + state.b2 + x * 0.1848f;
+        }
+      }
+      buffer.addFrom(ch, start, m_scratch.data(), n, level);
+      start += n;
     }
   }
 }
 
+void NoiseGenerator::fill(std::span<float> samples) {
+  size_t i = 0;
+  for (; i + s_num_lanes <= samples.size(); i += s_num_lanes) {
+    next(samples.data() + i);
+  }
+  if (i < samples.size()) {
+    std::array<float, s_num_lanes> tail;
+    next(tail.data());
+    std::copy_n(tail.begin(), samples.size() - i, samples.begin() + i);
+  }
+}
+
+void NoiseGenerator::next(float* out) {
+  // See https://prng.di.unimi.it/xoshiro128plus.c
+  auto& [s0, s1, s2, s3] = m_state;
+  for (size_t k = 0; k < s_num_lanes; k++) {
+    uint32_t result = s0[k] + s3[k];
+    uint32_t t = s1[k] << 9;
+    s2[k] ^= s0[k];
+    s3[k] ^= s1[k];
+    s1[k] ^= s2[k];
+    s0[k] ^= s3[k];
+    s2[k] ^= t;
+    s3[k] = std::rotl(s3[k], 11);
+    // The upper 24 bits are the best quality and fit exactly in a float
+    out[k] = static_cast<float>(result >> 8) * 0x1.0p-24f - 0.5f;
+  }
+}
+
 BiquadFilter::BiquadFilter(GlynthProcessor& processor_ref,
                            juce::AudioParameterFloat* freq_param,
                            juce::AudioParameterFloat* res_param)
@@ -321,96 +489,191 @@ void HighPassFilter::configure(float freq, float res) {
 TriggerHandler::TriggerHandler(GlynthProcessor& processor_ref,
                                const int channel)
     : SubProcessor(processor_ref), m_channel(channel) {
-  startTimerHz(60);
+  // Reserve once so that assembling bursts never allocates
+  m_bursts.forEach([](auto& burst) { burst.reserve(s_max_burst_length); });
+  m_analysis_thread->addTap(*this);
 }
 
+TriggerHandler::~TriggerHandler() { m_analysis_thread->removeTap(*this); }
+
 void TriggerHandler::prepareToPlay(double sample_rate, int) {
   double cooldown_samples = sample_rate * s_trigger_cooldown;
-  m_burst_length = static_cast<size_t>(cooldown_samples);
-  m_burst_buffer.reserve(m_burst_length);
+  m_burst_length = std::min(static_cast<size_t>(cooldown_samples),
+                            s_max_burst_length);
 }
 
 void TriggerHandler::processBlock(juce::AudioBuffer<float>& buffer,
                                   juce::MidiBuffer&) {
   size_t n = static_cast<size_t>(buffer.getNumSamples());
-  auto buffer_ptr = buffer.getReadPointer(m_channel);
+  // Mono layouts only have one channel to look at
+  int channel = std::min(m_channel, buffer.getNumChannels() - 1);
+  auto buffer_ptr = buffer.getReadPointer(channel);
+  float thresh = s_trigger_threshold;
   for (size_t i = 0; i < n; i++) {
     float x = buffer_ptr[i];
-    float thresh = s_trigger_threshold;
     // Rising edge trigger based on threshold
-    m_block.add(x, m_prev_sample < thresh && x >= thresh);
-    if (m_block.full()) {
-      if (!m_blocks.try_enqueue(std::move(m_block))) {
-        // This means the consumer wasn't pulling from the queue fast enough
-        throw GlynthError("Block usage is slower than generation!");
-      }
-      // m_block is moved from, so needs to be reset
-      m_block = Block();
+    if (m_prev_sample < thresh && x >= thresh) {
+      m_triggers.write(m_position + i);
     }
     m_prev_sample = x;
   }
-}
-
-void TriggerHandler::timerCallback() {
-  // Read trigger blocks from the queue into a burst buffer.
-  // Runs in the timer thread so allocations are fine
-  Block block;
-  while (m_blocks.try_dequeue(block)) {
-    auto trigger = block.trigger();
-    for (size_t i = 0; i < block.size(); i++) {
-      float x = block[i];
-      if (!m_triggered && trigger.has_value() && i == trigger.value()) {
-        m_triggered = true;
-      }
-      if (m_triggered) {
-        m_burst_buffer.push_back(x);
-        if (m_burst_buffer.size() == m_burst_length) {
-          m_burst_buffer_opt.emplace(std::move(m_burst_buffer));
-          m_triggered = false;
-          m_burst_buffer.clear();
+  // Overwrites the oldest samples if the consumer has fallen behind
+  m_samples.write(std::span(buffer_ptr, n));
+  m_position += n;
+}
+
+void TriggerHandler::analyze() {
+  GLYNTH_TRACE_SCOPE("TriggerHandler::analyze");
+  // Assemble bursts from the rings on the analysis thread
+  size_t burst_length = m_burst_length;
+  if (burst_length == 0) {
+    // Not prepared yet
+    return;
+  }
+  auto trigger_end = m_triggers.end();
+  m_trigger_read = std::max(m_trigger_read, m_triggers.begin());
+  while (true) {
+    if (!m_burst_start.has_value()) {
+      // Find the first trigger outside of the previous burst
+      while (m_trigger_read < trigger_end && !m_burst_start.has_value()) {
+        // A single item never wraps, so it's always in the first span
+        auto spans = m_triggers.read(m_trigger_read, m_trigger_read + 1);
+        auto position = spans[0][0];
+        if (!m_triggers.validate(m_trigger_read)) {
+          // Lapped while reading, so skip ahead to what's still intact
+          m_trigger_read = m_triggers.begin();
+          continue;
+        }
+        m_trigger_read++;
+        if (position >= m_cooldown_end) {
+          m_burst_start = position;
         }
       }
+      if (!m_burst_start.has_value()) {
+        return;
+      }
     }
+
+    auto start = *m_burst_start;
+    auto end = start + burst_length;
+    if (start < m_samples.begin()) {
+      // Too old; the start of the burst has already been overwritten
+      m_burst_start = std::nullopt;
+      continue;
+    }
+    if (end > m_samples.end()) {
+      // Wait for the audio thread to produce the rest of the burst
+      return;
+    }
+    // Never reallocates since every buffer has s_max_burst_length reserved
+    auto& burst = m_bursts.back();
+    burst.clear();
+    for (auto span : m_samples.read(start, end)) {
+      burst.insert(burst.end(), span.begin(), span.end());
+    }
+    if (m_samples.validate(start)) {
+      m_bursts.publish();
+      m_cooldown_end = end;
+    }
+    m_burst_start = std::nullopt;
   }
 }
 
-std::optional<std::vector<float>> TriggerHandler::getBurstBuffer() {
-  if (m_burst_buffer_opt.has_value()) {
-    auto res = std::move(*m_burst_buffer_opt);
-    m_burst_buffer_opt = std::nullopt;
-    return res;
-  } else {
-    return std::nullopt;
+const std::vector<float>* TriggerHandler::getBurstBuffer() {
+  return m_bursts.acquire();
+}
+
+XYTap::XYTap(GlynthProcessor& processor_ref) : SubProcessor(processor_ref) {}
+
+void XYTap::prepareToPlay(double sample_rate, int) {
+  m_sample_rate = sample_rate;
+}
+
+void XYTap::processBlock(juce::AudioBuffer<float>& buffer,
+                         juce::MidiBuffer&) {
+  int n = buffer.getNumSamples();
+  // Skipped so that an idle host doesn't keep the editor drawing
+  if (juce::exactlyEqual(buffer.getMagnitude(0, n), 0.0f)) {
+    return;
+  }
+  // Mono layouts trace a diagonal line
+  auto* x = buffer.getReadPointer(0);
+  auto* y = buffer.getReadPointer(std::min(1, buffer.getNumChannels() - 1));
+  std::array<glm::vec2, s_chunk_length> chunk;
+  for (int start = 0; start < n; start += s_chunk_length) {
+    int length = std::min(n - start, s_chunk_length);
+    for (int i = 0; i < length; i++) {
+      chunk[static_cast<size_t>(i)] = glm::vec2(x[start + i], y[start + i]);
+    }
+    // Overwrites the oldest frames if the editor has fallen behind
+    m_frames.write(std::span(chunk.data(), static_cast<size_t>(length)));
   }
 }
 
+void XYTap::drain(std::vector<glm::vec2>& frames, size_t max_frames) {
+  auto end = m_frames.end();
+  auto newest = end - std::min(end, FrameRing::Position{max_frames});
+  auto from = std::max({m_read.load(), m_frames.begin(), newest});
+  size_t old_size = frames.size();
+  for (auto span : m_frames.read(from, end)) {
+    frames.insert(frames.end(), span.begin(), span.end());
+  }
+  if (!m_frames.validate(from)) {
+    // Lapped while copying. Only the oldest frames can be torn, so drop
+    // those and keep the rest of the trace
+    auto torn = std::min(static_cast<size_t>(m_frames.validBegin() - from),
+                         frames.size() - old_size);
+    auto first = frames.begin() + static_cast<std::ptrdiff_t>(old_size);
+    frames.erase(first, first + static_cast<std::ptrdiff_t>(torn));
+  }
+  m_read = end;
+}
+
 Synth::Synth(GlynthProcessor& processor_ref,
              juce::AudioParameterFloat& attack_ms,
-             juce::AudioParameterFloat& decay_ms)
-    : SubProcessor(processor_ref) {
+             juce::AudioParameterFloat& decay_ms, size_t num_voices)
+    : SubProcessor(processor_ref), m_attack_param(attack_ms),
+      m_decay_param(decay_ms),
+      m_outline_reader(processor_ref.getOutlineSnapshots()) {
   attack_ms.addListener(this);
   decay_ms.addListener(this);
-  for (size_t i = 0; i < 32; i++) {
+  // Voices hold a reference to their own state, so they must never move
+  m_voices.reserve(num_voices);
+  for (size_t i = 0; i < num_voices; i++) {
     m_voices.emplace_back(m_wavetable, attack_ms.get(), decay_ms.get());
   }
 }
 
+Synth::~Synth() {
+  m_attack_param.removeListener(this);
+  m_decay_param.removeListener(this);
+}
+
 void Synth::prepareToPlay(double sample_rate, int) {
   m_sample_rate = sample_rate;
 }
 
 void Synth::processBlock(juce::AudioBuffer<float>& buffer,
                          juce::MidiBuffer& midi_messages) {
+  auto* outline = m_outline_reader.acquire();
+  if (outline != nullptr && outline->version != m_outline_version) {
+    m_outline_version = outline->version;
+    if (outline->data->has_wavetable) {
+      swapWavetable(outline->data->wavetable);
+    }
+  }
   juce::MidiBufferIterator it = midi_messages.begin();
   for (int i = 0; i < buffer.getNumSamples(); i++) {
     // Handle all midi messages happening at sample i
     while (it != midi_messages.end() && (*it).samplePosition == i) {
-      // Process the midi message
-      auto&& msg = (*it).getMessage();
-      auto&& description = msg.getDescription().toStdString();
-      fmt::println(Logger::file, "MIDI message at buffer sample {}: {}", i,
-                   description);
-
+      auto metadata = *it;
+      it++;
+      // Note messages are at most 3 bytes, which MidiMessage stores inline.
+      // Longer ones (like SysEx) would allocate, and aren't handled anyway
+      if (metadata.numBytes > 3) {
+        continue;
+      }
+      auto msg = metadata.getMessage();
       if (msg.isNoteOn()) {
         auto note = msg.getNoteNumber();
         // Use first inactive voice, or voice with lowest ID if all are active
@@ -432,8 +695,6 @@ void Synth::processBlock(juce::AudioBuffer<float>& buffer,
           }
         }
       }
-
-      it++;
     }
 
     for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
@@ -449,18 +710,18 @@ void Synth::processBlock(juce::AudioBuffer<float>& buffer,
 }
 
 void Synth::parameterValueChanged(int index, float new_value) {
-  if (auto& attack_param = m_processor_ref.getParamById("attack");
-      attack_param.getParameterIndex() == index) {
-    auto range = attack_param.getNormalisableRange();
+  // May be called on the audio thread during automation, so this avoids
+  // getParamById, which allocates
+  if (m_attack_param.getParameterIndex() == index) {
+    auto& range = m_attack_param.getNormalisableRange();
     float value = range.convertFrom0to1(new_value);
     for (auto& voice : m_voices) {
       voice.setAttack(value, m_sample_rate);
     }
   }
 
-  else if (auto& decay_param = m_processor_ref.getParamById("decay");
-           decay_param.getParameterIndex() == index) {
-    auto range = decay_param.getNormalisableRange();
+  else if (m_decay_param.getParameterIndex() == index) {
+    auto& range = m_decay_param.getNormalisableRange();
     float value = range.convertFrom0to1(new_value);
     for (auto& voice : m_voices) {
       voice.setDecay(value, m_sample_rate);
@@ -481,32 +742,12 @@ std::optional<size_t> Synth::getOldestVoiceWithState(SynthVoice::State state) {
   return best_i;
 }
 
-void Synth::updateWavetable(const Outline& outline) {
-  size_t n = Wavetable::s_num_samples;
-  auto samples = outline.sample(n);
-  auto bbox = outline.bbox();
-  float x_mean = 0;
-  float y_mean = 0;
-  std::array<float, Wavetable::s_num_samples> ch0;
-  std::array<float, Wavetable::s_num_samples> ch1;
-  for (size_t i = 0; i < n; i++) {
-    ch0[i] = (samples[i].x - bbox.min.x) / bbox.width() * 2;
-    ch1[i] = (samples[i].y - bbox.min.y) / bbox.height() * 2;
-    x_mean += ch0[i];
-    y_mean += ch1[i];
-  }
-  x_mean /= static_cast<float>(n);
-  y_mean /= static_cast<float>(n);
-  // Subtract the mean so there's no DC component
-  for (size_t i = 0; i < n; i++) {
-    ch0[i] -= x_mean;
-    ch1[i] -= y_mean;
-  }
-
+void Synth::swapWavetable(const WavetableSamples& samples) {
+  GLYNTH_TRACE_SCOPE("Synth::swapWavetable");
   m_wavetable.ch0_old = m_wavetable.ch0;
-  std::copy(ch0.begin(), ch0.end(), m_wavetable.ch0.begin());
+  m_wavetable.ch0 = samples.ch0;
   m_wavetable.ch1_old = m_wavetable.ch1;
-  std::copy(ch1.begin(), ch1.end(), m_wavetable.ch1.begin());
+  m_wavetable.ch1 = samples.ch1;
   for (auto& voice : m_voices) {
     voice.crossfade();
   }
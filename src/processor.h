@@ -1,12 +1,16 @@
 #pragma once
 
+#include "analysis_thread.h"
 #include "error.h"
-#include "font_manager.h"
+#include "load_meter.h"
+#include "outline_builder.h"
 #include "outliner.h"
+#include "rt_check.h"
+#include "spsc_ring.h"
+#include "tracer.h"
+#include "triple_buffer.h"
 
 #include <juce_audio_processors/juce_audio_processors.h>
-#include <random>
-#include <readerwriterqueue.h>
 
 class GlynthProcessor;
 class SubProcessor {
@@ -20,6 +24,8 @@ public:
     // Default prepareToPlay is a no-op
     juce::ignoreUnused(sample_rate, samples_per_block);
   }
+  // Short label used when reporting per-stage load
+  virtual std::string_view getName() const = 0;
 
 protected:
   GlynthProcessor& m_processor_ref;
@@ -27,6 +33,8 @@ protected:
 
 class Synth;
 class TriggerHandler;
+class XYTap;
+class CorruptionSilencer;
 
 class GlynthProcessor final : public juce::AudioProcessor, public juce::Timer {
 public:
@@ -64,32 +72,61 @@ public:
   // All parameters are float values
   juce::AudioParameterFloat& getParamById(std::string_view id);
 
+  // Outlines are rebuilt asynchronously, so these return immediately
   void setOutlineFace(std::string_view face_name);
   void setOutlineText(std::string_view outline_text);
-  const Outline& getOutline();
-  FT_Face getOutlineFace();
   std::string_view getOutlineText();
+  std::string_view getOutlineFace();
+  // Blocks until the latest outline change has reached the synth. Returns
+  // false on timeout
+  bool waitForOutline(int timeout_ms);
+  OutlineSnapshotStore& getOutlineSnapshots();
   TriggerHandler& getTriggerHandler(int channel);
+  XYTap& getXYTap();
+#ifdef GLYNTH_LOAD_METER
+  const LoadMeter& getLoadMeter() const;
+#endif
 
 private:
   inline static auto s_io_layouts = BusesProperties().withOutput(
       "Output", juce::AudioChannelSet::stereo(), true);
 
+  std::array<juce::RangedAudioParameter*, 8> getParams();
+
+#ifdef GLYNTH_TRACE
+  // Keeps the trace file open for as long as any instance exists
+  juce::SharedResourcePointer<Tracer> m_tracer;
+#endif
+
   juce::AudioParameterFloat& m_hpf_freq;
   juce::AudioParameterFloat& m_hpf_res;
   juce::AudioParameterFloat& m_lpf_freq;
   juce::AudioParameterFloat& m_lpf_res;
   juce::AudioParameterFloat& m_attack_ms;
   juce::AudioParameterFloat& m_decay_ms;
-
+  juce::AudioParameterFloat& m_noise_level;
+  juce::AudioParameterChoice& m_noise_color;
+
+  // Constructed before the synth, which reads from it
+  OutlineSnapshotStore m_outline_snapshots;
+  // For saving the built outline with the state. Hosts may save from any
+  // thread, so the reader is guarded
+  std::mutex m_state_mutex;
+  OutlineSnapshotStore::Reader m_state_reader;
   Synth& m_synth;
   TriggerHandler& m_trigger_handler_x;
   TriggerHandler& m_trigger_handler_y;
+  XYTap& m_xy_tap;
+  CorruptionSilencer& m_silencer;
   std::string m_outline_text = "Glynth";
   std::string m_outline_face = "SplineSansMono-Medium";
-  Outline m_outline;
-  FontManager m_font_manager;
   std::vector<std::unique_ptr<SubProcessor>> m_processors;
+#ifdef GLYNTH_LOAD_METER
+  // One stage per entry of m_processors, in the same order
+  std::unique_ptr<LoadMeter> m_load_meter;
+#endif
+  // Declared last so its thread stops before the synth it feeds is destroyed
+  OutlineBuilder m_outline_builder;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GlynthProcessor)
 };
@@ -99,21 +136,55 @@ public:
   CorruptionSilencer(GlynthProcessor& processor_ref);
   void processBlock(juce::AudioBuffer<float>& buffer,
                     juce::MidiBuffer& midi_messages) override;
+  inline std::string_view getName() const override { return "Silencer"; }
+  // Logs whatever processBlock flagged since the last call. Printing isn't
+  // real-time safe, so this is called from the processor's timer instead
+  void logWarnings();
 
 private:
+  static constexpr uint8_t s_non_finite = 0b001;
+  static constexpr uint8_t s_out_of_range = 0b010;
+  static constexpr uint8_t s_clamped = 0b100;
+
+  std::atomic<uint8_t> m_warnings = 0;
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CorruptionSilencer)
 };
 
 class NoiseGenerator : public SubProcessor {
 public:
-  NoiseGenerator(GlynthProcessor& processor_ref);
+  enum class Color { White, Pink };
+
+  NoiseGenerator(GlynthProcessor& processor_ref,
+                 juce::AudioParameterFloat* level_param,
+                 juce::AudioParameterChoice* color_param);
+  void prepareToPlay(double sample_rate, int samples_per_block) override;
   void processBlock(juce::AudioBuffer<float>& buffer,
                     juce::MidiBuffer& midi_messages) override;
+  inline std::string_view getName() const override { return "Noise"; }
+  // Fills samples with uniform white noise in [-0.5, 0.5)
+  void fill(std::span<float> samples);
 
 private:
-  std::random_device m_rd;
-  std::mt19937 m_gen;
-  std::uniform_real_distribution<float> m_dist;
+  // Number of xoshiro128+ streams advanced in lockstep. The state is stored
+  // as a structure of arrays so the update vectorizes across lanes
+  static constexpr size_t s_num_lanes = 8;
+  // Brings the pink filter output back to roughly the RMS of the input
+  static constexpr float s_pink_gain = 1.0f / 3;
+
+  // Writes s_num_lanes samples to out
+  void next(float* out);
+
+  juce::AudioParameterFloat* m_level_param;
+  juce::AudioParameterChoice* m_color_param;
+  std::array<std::array<uint32_t, s_num_lanes>, 4> m_state;
+  // Paul Kellet's economy pink noise filter, one state per channel
+  struct PinkState {
+    float b0 = 0, b1 = 0, b2 = 0;
+  };
+  std::vector<PinkState> m_pink_states;
+  // Holds one channel of noise before it gets mixed into the buffer
+  std::vector<float> m_scratch;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoiseGenerator)
 };
@@ -152,6 +223,7 @@ class LowPassFilter : public BiquadFilter {
 public:
   // Inherit the constructor
   using BiquadFilter::BiquadFilter;
+  inline std::string_view getName() const override { return "LPF"; }
 
 protected:
   void configure(float freq, float res) override;
@@ -164,6 +236,7 @@ class HighPassFilter : public BiquadFilter {
 public:
   // Inherit the constructor
   using BiquadFilter::BiquadFilter;
+  inline std::string_view getName() const override { return "HPF"; }
 
 protected:
   void configure(float freq, float res) override;
@@ -172,7 +245,7 @@ private:
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HighPassFilter)
 };
 
-class TriggerHandler : public SubProcessor, juce::Timer {
+class TriggerHandler : public SubProcessor, public AnalysisTap {
 public:
   // A rising edge across this value causes a trigger
   static constexpr float s_trigger_threshold = 1e-8f;
@@ -181,71 +254,97 @@ public:
   static constexpr float s_trigger_cooldown = 1.0f / 20;
 
   TriggerHandler(GlynthProcessor& processor_ref, const int channel);
+  ~TriggerHandler() override;
   void prepareToPlay(double sample_rate, int samples_per_block) override;
   void processBlock(juce::AudioBuffer<float>& buffer,
                     juce::MidiBuffer& midi_messages) override;
-  void timerCallback() override;
-  // Returns std::nullopt if the burst buffer hasn't changed
-  std::optional<std::vector<float>> getBurstBuffer();
+  void analyze() override;
+  inline std::string_view getName() const override {
+    return m_channel == 0 ? "Trigger (X)" : "Trigger (Y)";
+  }
+  // Returns nullptr if there hasn't been a new burst since the last call.
+  // Only call from a single consumer thread (the OpenGL thread)
+  const std::vector<float>* getBurstBuffer();
+  // Whether getBurstBuffer() would return a new burst. Only peeks, so it's
+  // safe from any thread
+  inline bool hasNewBurst() const { return m_bursts.pending(); }
 
 private:
-  struct Block {
-  public:
-    inline void add(float x, bool trigger = false) {
-      assert(m_size < m_samples.size());
-      m_samples[m_size] = x;
-      if (trigger) {
-        m_trigger = m_size;
-      }
-      m_size++;
-    }
-
-    inline size_t size() { return m_size; }
-    inline bool full() { return m_size == m_samples.size(); }
-    inline std::optional<size_t> trigger() { return m_trigger; }
-    inline float operator[](size_t i) { return m_samples[i]; }
-
-  private:
-    std::array<float, 64> m_samples;
-    std::optional<size_t> m_trigger = std::nullopt;
-    size_t m_size = 0;
-  };
+  // Enough history for a burst at 192 kHz plus several missed analysis ticks
+  using SampleRing = SpscRing<float, (1 << 16)>;
+  // Absolute sample positions of rising edges
+  using TriggerRing = SpscRing<SampleRing::Position, (1 << 10)>;
+  static constexpr size_t s_max_burst_length = SampleRing::s_capacity / 2;
 
   const int m_channel;
   // For getting samples off of the audio thread
-  moodycamel::ReaderWriterQueue<Block> m_blocks{1024};
+  SampleRing m_samples;
+  TriggerRing m_triggers;
+  // Audio thread state
   float m_prev_sample = 0;
-  size_t m_size = 0;
-  Block m_block;
+  SampleRing::Position m_position = 0;
+  // Analysis thread state
+  TriggerRing::Position m_trigger_read = 0;
+  std::optional<SampleRing::Position> m_burst_start;
+  // Triggers before this position fall within the previous burst
+  SampleRing::Position m_cooldown_end = 0;
   // Number of samples to store after a trigger
-  size_t m_burst_length;
-  std::vector<float> m_burst_buffer;
-  std::optional<std::vector<float>> m_burst_buffer_opt;
-  bool m_triggered = false;
+  std::atomic<size_t> m_burst_length = 0;
+  // Preallocated bursts handed from the analysis thread to the GL thread
+  TripleBuffer<std::vector<float>> m_bursts;
+  juce::SharedResourcePointer<AnalysisThread> m_analysis_thread;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TriggerHandler)
 };
 
+// Hands the stereo output to the editor's vectorscope as (x, y) frames. The
+// audio thread interleaves each block into a ring a chunk at a time, and the
+// OpenGL thread drains whatever is new each frame
+class XYTap : public SubProcessor {
+public:
+  // About 0.7 s at 96 kHz, so the editor can skip a few frames
+  using FrameRing = SpscRing<glm::vec2, (1 << 16)>;
+
+  explicit XYTap(GlynthProcessor& processor_ref);
+  void prepareToPlay(double sample_rate, int samples_per_block) override;
+  void processBlock(juce::AudioBuffer<float>& buffer,
+                    juce::MidiBuffer& midi_messages) override;
+  inline std::string_view getName() const override { return "XY Tap"; }
+  // Appends the frames written since the last call, keeping only the newest
+  // max_frames. Only call from a single consumer thread (the OpenGL thread)
+  void drain(std::vector<glm::vec2>& frames, size_t max_frames);
+  // Whether drain() would append anything. Safe from any thread
+  inline bool hasNewFrames() const { return m_frames.end() > m_read; }
+  inline double getSampleRate() const { return m_sample_rate; }
+
+private:
+  // Frames are interleaved on the stack in chunks of this many
+  static constexpr int s_chunk_length = 256;
+
+  FrameRing m_frames;
+  // Position after the last frame drained
+  std::atomic<FrameRing::Position> m_read = 0;
+  std::atomic<double> m_sample_rate = 44100;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(XYTap)
+};
+
 struct Wavetable {
-  static constexpr size_t s_num_samples = 512;
+  static constexpr size_t s_num_samples = WavetableSamples::s_num_samples;
 
-  std::array<float, s_num_samples> ch0;
-  std::array<float, s_num_samples> ch1;
+  std::array<float, s_num_samples> ch0{};
+  std::array<float, s_num_samples> ch1{};
   // For cross-fading
-  std::array<float, s_num_samples> ch0_old;
-  std::array<float, s_num_samples> ch1_old;
+  std::array<float, s_num_samples> ch0_old{};
+  std::array<float, s_num_samples> ch1_old{};
 
+  // Called per sample on the audio thread, so it asserts instead of throwing
   inline std::span<float, s_num_samples> channel(size_t ch, bool old = false) {
-    if (ch == 0 && old == false) {
-      return ch0;
-    } else if (ch == 1 && old == false) {
-      return ch1;
-    } else if (ch == 0 && old == true) {
-      return ch0_old;
-    } else if (ch == 1 && old == true) {
-      return ch1_old;
+    jassert(ch < 2);
+    if (ch == 0) {
+      return old ? ch0_old : ch0;
     } else {
-      throw GlynthError("Bad channel index");
+      return old ? ch1_old : ch1;
     }
   }
 
@@ -301,19 +400,28 @@ class Synth : public SubProcessor,
               public juce::AudioProcessorParameter::Listener {
 public:
   Synth(GlynthProcessor& processor_ref, juce::AudioParameterFloat& attack_ms,
-        juce::AudioParameterFloat& decay_ms);
+        juce::AudioParameterFloat& decay_ms, size_t num_voices = 32);
+  // Unregisters from the parameters, which may outlive it, like in the bench
+  ~Synth() override;
 
   void prepareToPlay(double sample_rate, int samples_per_block) override;
   void processBlock(juce::AudioBuffer<float>& buffer,
                     juce::MidiBuffer& midi_messages) override;
   void parameterValueChanged(int index, float new_value) override;
   void parameterGestureChanged(int index, bool gesture_is_starting) override;
-  void updateWavetable(const Outline& outline);
+  inline std::string_view getName() const override { return "Synth"; }
 
 private:
   std::optional<size_t> getOldestVoiceWithState(SynthVoice::State state);
+  void swapWavetable(const WavetableSamples& samples);
+  // Kept to match listener callbacks by index without looking parameters up
+  juce::AudioParameterFloat& m_attack_param;
+  juce::AudioParameterFloat& m_decay_param;
   // Stereo wavetable referenced by all voices
   Wavetable m_wavetable;
+  // Checked at the start of each block for a newer outline
+  OutlineSnapshotStore::Reader m_outline_reader;
+  uint64_t m_outline_version = 0;
   std::vector<SynthVoice> m_voices;
   double m_sample_rate;
   float m_gain = 0.5f;
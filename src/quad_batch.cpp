@@ -0,0 +1,106 @@
+#include "quad_batch.h"
+#include "tracer.h"
+
+#include <algorithm>
+#include <array>
+
+QuadBatch::QuadBatch(ShaderManager& shader_manager)
+    : m_shader_manager(shader_manager) {
+  using namespace juce::gl;
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_quad_vbo);
+  glGenBuffers(1, &m_ebo);
+  glGenBuffers(1, &m_instance_vbo);
+  glBindVertexArray(m_vao);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+  std::array indices = {0u, 1u, 2u, 0u, 2u, 3u};
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices.data(),
+               GL_STATIC_DRAW);
+  // Counter-clockwise from the bottom left, doubling as texture coordinates
+  glBindBuffer(GL_ARRAY_BUFFER, m_quad_vbo);
+  std::array<GLfloat, 8> corners = {0, 0, 0, 1, 1, 1, 1, 0};
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners.data(),
+               GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, m_instance_vbo);
+  glEnableVertexAttribArray(1);
+  glEnableVertexAttribArray(2);
+  glVertexAttribDivisor(1, 1);
+  glVertexAttribDivisor(2, 1);
+  bindInstances(0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+QuadBatch::~QuadBatch() {
+  using namespace juce::gl;
+  glDeleteBuffers(1, &m_quad_vbo);
+  glDeleteBuffers(1, &m_ebo);
+  glDeleteBuffers(1, &m_instance_vbo);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void QuadBatch::add(const std::string& program_id, const Instance& instance) {
+  auto it = std::find_if(m_groups.begin(), m_groups.end(),
+                         [&](const auto& group) {
+                           return group.first == program_id;
+                         });
+  if (it == m_groups.end()) {
+    m_groups.emplace_back(program_id, std::vector<Instance>{instance});
+  } else {
+    it->second.push_back(instance);
+  }
+}
+
+void QuadBatch::drawOne(const std::string& program_id,
+                        const Instance& instance) {
+  using namespace juce::gl;
+  glBindVertexArray(m_vao); // Also binds m_ebo
+  glBindBuffer(GL_ARRAY_BUFFER, m_instance_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(Instance), &instance, GL_STREAM_DRAW);
+  bindInstances(0);
+  m_shader_manager.useProgram(program_id);
+  glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, 1);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+void QuadBatch::draw() {
+  GLYNTH_TRACE_SCOPE("QuadBatch::draw");
+  if (m_groups.empty()) {
+    return;
+  }
+  m_instances.clear();
+  for (auto& [program_id, instances] : m_groups) {
+    m_instances.insert(m_instances.end(), instances.begin(), instances.end());
+  }
+  using namespace juce::gl;
+  glBindVertexArray(m_vao); // Also binds m_ebo
+  glBindBuffer(GL_ARRAY_BUFFER, m_instance_vbo);
+  glBufferData(GL_ARRAY_BUFFER,
+               static_cast<GLsizeiptr>(m_instances.size() * sizeof(Instance)),
+               m_instances.data(), GL_STREAM_DRAW);
+  // Base instances need GL 4.2, so offset the attributes instead
+  size_t first = 0;
+  for (auto& [program_id, instances] : m_groups) {
+    bindInstances(first);
+    m_shader_manager.useProgram(program_id);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr,
+                            static_cast<GLsizei>(instances.size()));
+    first += instances.size();
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  m_groups.clear();
+}
+
+void QuadBatch::bindInstances(size_t first) {
+  using namespace juce::gl;
+  auto offset = first * sizeof(Instance);
+  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                        reinterpret_cast<const void*>(offset));
+  glVertexAttribPointer(
+      2, 1, GL_FLOAT, GL_FALSE, sizeof(Instance),
+      reinterpret_cast<const void*>(offset + offsetof(Instance, value)));
+}
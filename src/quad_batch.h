@@ -0,0 +1,48 @@
+#pragma once
+
+#include "shader_manager.h"
+
+#include <glm/glm.hpp>
+#include <juce_opengl/juce_opengl.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One unit quad shared by every rect-shaped component, drawn instanced with
+// the rect and any per-component values in an instance buffer. Instances
+// added over a frame are drawn together, one call per program, so
+// components sharing a program cost one draw and one program switch
+class QuadBatch {
+public:
+  struct Instance {
+    // Bottom left corner and size in window pixels
+    glm::vec4 rect{0};
+    // Passed through to the fragment shader, like a knob's value
+    float value = 0;
+  };
+
+  // Create and destroy with the GL context active
+  explicit QuadBatch(ShaderManager& shader_manager);
+  ~QuadBatch();
+  // Queues an instance until the next draw()
+  void add(const std::string& program_id, const Instance& instance);
+  // Draws one instance straight away, for components that bind their own
+  // textures or set their own uniforms first
+  void drawOne(const std::string& program_id, const Instance& instance = {});
+  // Draws everything added since the last draw, grouped by program in the
+  // order each program was first added, then clears the batch
+  void draw();
+
+private:
+  // Points the instance attributes at an offset into the bound buffer
+  void bindInstances(size_t first);
+
+  ShaderManager& m_shader_manager;
+  GLuint m_vao = 0, m_quad_vbo = 0, m_ebo = 0, m_instance_vbo = 0;
+  // Queued instances per program
+  std::vector<std::pair<std::string, std::vector<Instance>>> m_groups;
+  // Groups flattened for upload, kept to reuse its allocation
+  std::vector<Instance> m_instances;
+
+  JUCE_DECLARE_NON_COPYABLE(QuadBatch)
+};
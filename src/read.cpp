@@ -1,5 +1,6 @@
 #include "error.h"
 #include "fonts.h"
+#include "outline_pack.h"
 #include "outliner.h"
 
 #include <fmt/base.h>
@@ -8,18 +9,127 @@
 #include <freetype/freetype.h>
 #include <freetype/ftbbox.h>
 #include <freetype/ftoutln.h>
+#include <cstring>
 #include <fstream>
 #include <npy/npy.h>
 #include <npy/tensor.h>
 #include <string>
+#include <string_view>
+#include <vector>
 
-int main() {
+// Writes the outline of every character below OutlinePack::s_num_chars, for
+// each embedded font, in font units
+static void writePack(FT_Library library, const char* path) {
+  std::vector<OutlinePack::Face> faces;
+  std::vector<OutlinePack::Glyph> glyphs;
+  std::vector<OutlinePack::Segment> segments;
+  for (int i = 0; i < fonts::namedResourceListSize; i++) {
+    std::string_view filename = fonts::originalFilenames[i];
+    if (!filename.ends_with(".ttf")) {
+      continue;
+    }
+    // Named the same way FontRegistry looks faces up
+    auto name = filename.substr(0, filename.size() - 4);
+    OutlinePack::Face pack_face{};
+    if (name.size() >= sizeof(pack_face.name)) {
+      throw GlynthError(fmt::format(R"(Face name "{}" is too long)", name));
+    }
+    std::memcpy(pack_face.name, name.data(), name.size());
+
+    int file_size;
+    auto file_base =
+        fonts::getNamedResource(fonts::namedResourceList[i], file_size);
+    FT_Face face;
+    FT_Error err;
+    if ((err = FT_New_Memory_Face(library,
+                                  reinterpret_cast<const FT_Byte*>(file_base),
+                                  file_size, 0, &face))) {
+      throw FreetypeError(FT_Error_String(err));
+    }
+    pack_face.units_per_em = face->units_per_EM;
+    pack_face.height = face->height;
+    pack_face.descender = face->descender;
+    pack_face.first_glyph = static_cast<uint32_t>(glyphs.size());
+    faces.push_back(pack_face);
+
+    for (FT_ULong c = 0; c < OutlinePack::s_num_chars; c++) {
+      OutlinePack::Glyph pack_glyph{};
+      pack_glyph.first_segment = static_cast<uint32_t>(segments.size());
+      if (!FT_Load_Char(face, c, FT_LOAD_NO_SCALE) &&
+          face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+        FT_GlyphSlot glyph = face->glyph;
+        // Unscaled coordinates are whole font units, not 26.6, so undo the
+        // division in Segment. Exact, since it's a power of two
+        std::vector<Segment> glyph_segments;
+        Outline::decompose(glyph->outline, FT_Vector{0, 0}, glyph_segments);
+        for (auto& segment : glyph_segments) {
+          OutlinePack::Segment pack_segment{};
+          pack_segment.order = static_cast<uint32_t>(segment.order());
+          pack_segment.length = segment.length() * 64;
+          auto points = segment.points();
+          for (size_t k = 0; k < points.size(); k++) {
+            pack_segment.points[2 * k] = points[k].x * 64;
+            pack_segment.points[2 * k + 1] = points[k].y * 64;
+          }
+          segments.push_back(pack_segment);
+        }
+        FT_BBox bbox;
+        if ((err = FT_Outline_Get_BBox(&glyph->outline, &bbox))) {
+          throw FreetypeError(FT_Error_String(err));
+        }
+        pack_glyph.advance = static_cast<float>(glyph->advance.x);
+        pack_glyph.width = static_cast<float>(glyph->metrics.width);
+        pack_glyph.min_x = static_cast<float>(bbox.xMin);
+        pack_glyph.min_y = static_cast<float>(bbox.yMin);
+        pack_glyph.max_x = static_cast<float>(bbox.xMax);
+        pack_glyph.max_y = static_cast<float>(bbox.yMax);
+        pack_glyph.num_segments =
+            static_cast<uint32_t>(glyph_segments.size());
+        pack_glyph.is_outline = 1;
+      }
+      glyphs.push_back(pack_glyph);
+    }
+    FT_Done_Face(face);
+  }
+
+  OutlinePack::Header header{
+      .magic = OutlinePack::s_magic,
+      .version = OutlinePack::s_version,
+      .num_faces = static_cast<uint32_t>(faces.size()),
+      .num_segments = static_cast<uint32_t>(segments.size()),
+  };
+  std::ofstream file(path, std::ios::binary);
+  auto write = [&file](const auto& records) {
+    file.write(reinterpret_cast<const char*>(records.data()),
+               static_cast<std::streamsize>(records.size() *
+                                            sizeof(records[0])));
+  };
+  write(std::span(&header, 1));
+  write(faces);
+  write(glyphs);
+  write(segments);
+  if (!file) {
+    throw GlynthError(fmt::format(R"(Unable to write "{}")", path));
+  }
+  fmt::println("Wrote {} faces and {} segments to {}", faces.size(),
+               segments.size(), path);
+}
+
+// Usage: read [--pack <path>]
+// With no arguments, writes a preview of one outline to out/
+int main(int argc, char** argv) {
   FT_Error err;
   FT_Library library;
   if ((err = FT_Init_FreeType(&library))) {
     throw FreetypeError(FT_Error_String(err));
   }
 
+  if (argc == 3 && std::string_view(argv[1]) == "--pack") {
+    writePack(library, argv[2]);
+    FT_Done_FreeType(library);
+    return 0;
+  }
+
   std::vector<FT_Byte> data(fonts::SplineSansMonoMedium_ttfSize);
   std::memcpy(data.data(), fonts::SplineSansMonoMedium_ttf, data.size());
 
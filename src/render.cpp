@@ -0,0 +1,233 @@
+#include "processor.h"
+
+#include <chrono>
+#include <fmt/base.h>
+#include <fmt/format.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <npy/npy.h>
+#include <npy/tensor.h>
+
+// Renders a Standard MIDI File through GlynthProcessor without an editor.
+//
+//   glynth_render <input.mid> <output.wav|output.npy> [--sample-rate=44100]
+//       [--block-size=512] [--text=Glynth] [--face=SplineSansMono-Medium]
+//       [--tail=1.0] [--rt-check]
+//
+// npy output has shape (num_channels, num_samples), matching what the scripts
+// in script/ expect from tensor.npy. --rt-check aborts with a backtrace on
+// the first real-time violation, and requires a Debug build with
+// GLYNTH_RT_CHECK
+
+static void printUsage() {
+  fmt::println(stderr,
+               "Usage: glynth_render <input.mid> <output.wav|output.npy> "
+               "[--sample-rate=44100] [--block-size=512] [--text=Glynth] "
+               "[--face=SplineSansMono-Medium] [--tail=1.0] [--rt-check]");
+}
+
+static juce::MidiMessageSequence readMidiFile(const juce::File& file) {
+  juce::FileInputStream stream(file);
+  if (!stream.openedOk()) {
+    throw GlynthError(fmt::format(R"(Unable to open "{}")",
+                                  file.getFullPathName().toStdString()));
+  }
+  juce::MidiFile midi_file;
+  if (!midi_file.readFrom(stream)) {
+    throw GlynthError(fmt::format(R"("{}" is not a valid MIDI file)",
+                                  file.getFullPathName().toStdString()));
+  }
+  midi_file.convertTimestampTicksToSeconds();
+  // Flatten all tracks into one sequence since the synth is single-timbral
+  juce::MidiMessageSequence sequence;
+  for (int t = 0; t < midi_file.getNumTracks(); t++) {
+    sequence.addSequence(*midi_file.getTrack(t), 0.0);
+  }
+  sequence.sort();
+  return sequence;
+}
+
+static void writeWav(const juce::File& file,
+                     const juce::AudioBuffer<float>& output,
+                     double sample_rate) {
+  file.deleteFile();
+  std::unique_ptr<juce::OutputStream> stream = file.createOutputStream();
+  if (stream == nullptr) {
+    throw GlynthError(fmt::format(R"(Unable to write to "{}")",
+                                  file.getFullPathName().toStdString()));
+  }
+  juce::WavAudioFormat format;
+  std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(
+      stream.get(), sample_rate,
+      static_cast<unsigned int>(output.getNumChannels()), 32, {}, 0));
+  if (writer == nullptr) {
+    throw GlynthError("Unable to create WAV writer");
+  }
+  // The writer owns the stream now
+  stream.release();
+  writer->writeFromAudioSampleBuffer(output, 0, output.getNumSamples());
+}
+
+static void writeNpy(const juce::File& file,
+                     const juce::AudioBuffer<float>& output) {
+  auto num_channels = static_cast<size_t>(output.getNumChannels());
+  auto num_samples = static_cast<size_t>(output.getNumSamples());
+  // Channels are stored one after another since npy data is row-major
+  std::vector<float> samples(num_channels * num_samples);
+  for (size_t ch = 0; ch < num_channels; ch++) {
+    auto* src = output.getReadPointer(static_cast<int>(ch));
+    std::copy_n(src, num_samples, samples.begin() + ch * num_samples);
+  }
+  npy::tensor<float> output_npy(std::vector<size_t>{num_channels, num_samples});
+  output_npy.copy_from(samples.data(), samples.size());
+  npy::save(file.getFullPathName().toStdString(), output_npy);
+}
+
+// Returns the exit code. Throws if a file can't be read or written
+static int render(const juce::ArgumentList& args) {
+  std::vector<juce::File> paths;
+  for (auto& arg : args.arguments) {
+    if (!arg.isOption()) {
+      paths.push_back(arg.resolveAsFile());
+    }
+  }
+  if (paths.size() != 2 || args.containsOption("--help|-h")) {
+    printUsage();
+    return 1;
+  }
+  auto& midi_path = paths[0];
+  auto& output_path = paths[1];
+  if (!output_path.hasFileExtension("wav;npy")) {
+    printUsage();
+    return 1;
+  }
+
+  auto option = [&args](juce::StringRef name, juce::String fallback) {
+    return args.containsOption(name) ? args.getValueForOption(name) : fallback;
+  };
+  double sample_rate = option("--sample-rate", "44100").getDoubleValue();
+  int block_size = option("--block-size", "512").getIntValue();
+  double tail = option("--tail", "1.0").getDoubleValue();
+  if (sample_rate <= 0 || block_size <= 0 || tail < 0) {
+    printUsage();
+    return 1;
+  }
+
+  if (args.containsOption("--rt-check")) {
+#ifdef GLYNTH_RT_CHECK
+    rt_check::setFatal(true);
+#else
+    fmt::println(stderr, "--rt-check requires a Debug build with "
+                         "GLYNTH_RT_CHECK=ON");
+    return 1;
+#endif
+  }
+
+  auto sequence = readMidiFile(midi_path);
+  double duration = sequence.getEndTime() + tail;
+  int num_samples = static_cast<int>(std::ceil(duration * sample_rate));
+  constexpr int num_channels = 2;
+
+  GlynthProcessor processor;
+  processor.setPlayConfigDetails(0, num_channels, sample_rate, block_size);
+  processor.prepareToPlay(sample_rate, block_size);
+  auto face_name = option("--face", juce::String(std::string(
+                                        processor.getOutlineFace())))
+                       .toStdString();
+  auto text = option("--text", juce::String(std::string(
+                                   processor.getOutlineText())))
+                  .toStdString();
+  processor.setOutlineFace(face_name);
+  processor.setOutlineText(text);
+  // Outlines are built on a worker thread, so wait for the synth to get it
+  if (!processor.waitForOutline(10000)) {
+    fmt::println(stderr, "Timed out building the outline");
+    return 1;
+  }
+  // A failed build is only logged, leaving the previous outline published
+  OutlineSnapshotStore::Reader reader(processor.getOutlineSnapshots());
+  auto* snapshot = reader.acquire();
+  if (snapshot == nullptr || snapshot->face_name != face_name ||
+      snapshot->text != text) {
+    fmt::println(stderr, R"(Unable to build "{}" in face "{}")", text,
+                 face_name);
+    return 1;
+  }
+
+  juce::AudioBuffer<float> output(num_channels, num_samples);
+  juce::AudioBuffer<float> block(num_channels, block_size);
+  juce::MidiBuffer midi;
+  int next_event = 0;
+  using clock = std::chrono::steady_clock;
+  clock::duration total_time{};
+  clock::duration max_block_time{};
+  int num_blocks = 0;
+  for (int start = 0; start < num_samples; start += block_size) {
+    int n = std::min(block_size, num_samples - start);
+    // Shrinking the last block keeps the allocation
+    block.setSize(num_channels, n, false, false, true);
+    // Gather the events that fall within this block
+    midi.clear();
+    while (next_event < sequence.getNumEvents()) {
+      auto& message = sequence.getEventPointer(next_event)->message;
+      int position = juce::roundToInt(message.getTimeStamp() * sample_rate);
+      if (position >= start + n) {
+        break;
+      }
+      midi.addEvent(message, std::clamp(position - start, 0, n - 1));
+      next_event++;
+    }
+
+    auto block_start = clock::now();
+    processor.processBlock(block, midi);
+    auto block_time = clock::now() - block_start;
+    total_time += block_time;
+    max_block_time = std::max(max_block_time, block_time);
+    num_blocks++;
+
+    for (int ch = 0; ch < num_channels; ch++) {
+      output.copyFrom(ch, start, block, ch, 0, n);
+    }
+  }
+
+  if (output_path.hasFileExtension("wav")) {
+    writeWav(output_path, output, sample_rate);
+  } else {
+    writeNpy(output_path, output);
+  }
+
+  using seconds = std::chrono::duration<double>;
+  double audio_seconds = num_samples / sample_rate;
+  double render_seconds = seconds(total_time).count();
+  double budget_seconds = block_size / sample_rate;
+  fmt::println("Rendered {:.2f} s of audio in {:.3f} s ({} blocks of {})",
+               audio_seconds, render_seconds, num_blocks, block_size);
+  fmt::println("Real-time factor: {:.1f}x",
+               audio_seconds / std::max(render_seconds, 1e-9));
+  fmt::println("Slowest block: {:.1f}% of the {:.2f} ms budget",
+               100 * seconds(max_block_time).count() / budget_seconds,
+               1000 * budget_seconds);
+#ifdef GLYNTH_LOAD_METER
+  auto stats = processor.getLoadMeter().getStats();
+  fmt::println("{:<12}{:>7}{:>7}{:>7}{:>7}", "stage", "mean", "p99", "max",
+               "miss");
+  for (auto& stage : stats.stages) {
+    fmt::println("{:<12}{:>6.1f}%{:>6.1f}%{:>6.1f}%{:>7}", stage.name,
+                 100 * stage.mean, 100 * stage.p99, 100 * stage.max,
+                 stage.misses);
+  }
+#endif
+  fmt::println(R"(Wrote "{}")", output_path.getFullPathName().toStdString());
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  // Sets up the message manager, which parts of the processor expect
+  juce::ScopedJuceInitialiser_GUI juce_initialiser;
+  juce::ArgumentList args(argc, argv);
+  try {
+    return render(args);
+  } catch (const std::exception& e) {
+    fmt::println(stderr, "{}", e.what());
+    return 1;
+  }
+}
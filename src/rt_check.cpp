@@ -0,0 +1,201 @@
+#include "rt_check.h"
+
+#ifdef GLYNTH_RT_CHECK
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <execinfo.h>
+#include <new>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <pthread.h>
+#endif
+
+namespace {
+
+// Plain thread_local ints need no dynamic initialization, so they are safe
+// to touch from inside malloc
+thread_local int t_realtime_depth = 0;
+thread_local int t_exempt_depth = 0;
+// Set while reporting, and while an outer hook already did the check
+thread_local bool t_suppressed = false;
+std::atomic<bool> g_fatal = false;
+std::atomic<size_t> g_violations = 0;
+
+class Suppress {
+public:
+  Suppress() : m_prev(t_suppressed) { t_suppressed = true; }
+  ~Suppress() { t_suppressed = m_prev; }
+
+private:
+  bool m_prev;
+};
+
+void violation(const char* what) {
+  if (t_realtime_depth == 0 || t_exempt_depth > 0 || t_suppressed) {
+    return;
+  }
+  // Reporting allocates, so don't report the report
+  Suppress suppress;
+  g_violations.fetch_add(1, std::memory_order_relaxed);
+  // Written straight to the fd to stay clear of stdio locks
+  char message[128];
+  int length = snprintf(message, sizeof(message),
+                        "Real-time violation: %s on the audio thread\n", what);
+  [[maybe_unused]] auto written =
+      write(STDERR_FILENO, message, static_cast<size_t>(length));
+  void* frames[64];
+  int num_frames = backtrace(frames, 64);
+  backtrace_symbols_fd(frames, num_frames, STDERR_FILENO);
+  if (g_fatal.load(std::memory_order_relaxed)) {
+    std::abort();
+  }
+}
+
+} // namespace
+
+namespace rt_check {
+
+RealtimeScope::RealtimeScope() { t_realtime_depth++; }
+RealtimeScope::~RealtimeScope() { t_realtime_depth--; }
+
+ExemptScope::ExemptScope() { t_exempt_depth++; }
+ExemptScope::~ExemptScope() { t_exempt_depth--; }
+
+void setFatal(bool fatal) { g_fatal = fatal; }
+
+size_t getViolationCount() { return g_violations; }
+
+} // namespace rt_check
+
+// Replacing the global operators works on every platform. The underlying
+// malloc is suppressed so each allocation is only reported once
+
+void* operator new(size_t size) {
+  violation("operator new");
+  Suppress suppress;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void* operator new(size_t size, std::align_val_t align) {
+  violation("operator new");
+  Suppress suppress;
+  auto alignment = static_cast<size_t>(align);
+  // aligned_alloc requires the size to be a multiple of the alignment
+  size = (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment;
+  if (void* ptr = std::aligned_alloc(alignment, size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+  return operator new(size, align);
+}
+
+void operator delete(void* ptr) noexcept {
+  violation("operator delete");
+  Suppress suppress;
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+  operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+  operator delete(ptr);
+}
+
+#ifdef __linux__
+
+// Interpose the C allocator, mutexes and exceptions by defining them in the
+// executable, which takes precedence over the shared libraries. glibc
+// exports its allocator under internal names, which avoids resolving malloc
+// through dlsym (which itself allocates)
+
+// Constant-initialized caches avoid the guard of a function-local static,
+// which could take a lock and recurse
+template <typename F>
+static F resolveNext(std::atomic<F>& cache, const char* name) {
+  F f = cache.load(std::memory_order_relaxed);
+  if (f == nullptr) {
+    f = reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+    cache.store(f, std::memory_order_relaxed);
+  }
+  return f;
+}
+
+extern "C" {
+
+void* __libc_malloc(size_t size) noexcept;
+void* __libc_calloc(size_t count, size_t size) noexcept;
+void* __libc_realloc(void* ptr, size_t size) noexcept;
+void __libc_free(void* ptr) noexcept;
+
+void* malloc(size_t size) noexcept {
+  violation("malloc");
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+  violation("calloc");
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+  violation("realloc");
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) noexcept {
+  violation("free");
+  __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+  using Lock = int (*)(pthread_mutex_t*);
+  static std::atomic<Lock> s_real = nullptr;
+  violation("pthread_mutex_lock");
+  return resolveNext(s_real, "pthread_mutex_lock")(mutex);
+}
+
+// The type is really a std::type_info*, but the compiler's builtin
+// declaration uses void*
+[[noreturn]] void __cxa_throw(void* exception, void* type,
+                              void (*destructor)(void*)) {
+  using Throw = void (*)(void*, void*, void (*)(void*));
+  static std::atomic<Throw> s_real = nullptr;
+  violation("throw");
+  resolveNext(s_real, "__cxa_throw")(exception, type, destructor);
+  __builtin_unreachable();
+}
+
+} // extern "C"
+
+#endif
+
+#endif
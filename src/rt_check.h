@@ -0,0 +1,44 @@
+#pragma once
+
+// Flags calls that aren't real-time safe while the audio thread is inside
+// processBlock: heap allocation, operator new/delete, mutex locks and
+// throwing. Each violation is reported on stderr with a backtrace. Only
+// built into Debug builds with GLYNTH_RT_CHECK, and malloc, mutex and throw
+// interception is Linux-only
+//
+//   GLYNTH_RT_SCOPE();  // The calling thread is real-time until scope exit
+//   GLYNTH_RT_EXEMPT(); // Deliberate one-off violations inside this scope
+
+#ifdef GLYNTH_RT_CHECK
+
+#include <cstddef>
+
+namespace rt_check {
+
+class RealtimeScope {
+public:
+  RealtimeScope();
+  ~RealtimeScope();
+};
+
+class ExemptScope {
+public:
+  ExemptScope();
+  ~ExemptScope();
+};
+
+// Aborts on the first violation instead of reporting and carrying on
+void setFatal(bool fatal);
+size_t getViolationCount();
+
+} // namespace rt_check
+
+#define GLYNTH_RT_SCOPE() rt_check::RealtimeScope glynth_rt_scope
+#define GLYNTH_RT_EXEMPT() rt_check::ExemptScope glynth_rt_exempt
+
+#else
+
+#define GLYNTH_RT_SCOPE()
+#define GLYNTH_RT_EXEMPT()
+
+#endif
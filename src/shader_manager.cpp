@@ -6,7 +6,6 @@
 #include <filesystem>
 #include <fmt/base.h>
 #include <fmt/format.h>
-#include <glm/gtc/type_ptr.hpp>
 #ifdef GLYNTH_HSR
 #include <fstream>
 #include <sstream>
@@ -87,38 +86,17 @@ bool ShaderManager::useProgram(const ProgramId& id) {
   }
 }
 
-bool ShaderManager::setUniform(const ProgramId& id, const std::string& name,
-                               Uniform value) {
+void ShaderManager::resolve(const ProgramId& id,
+                            uniform_detail::SlotBase& slot) {
   assert(m_context.isAttached() && m_context.isActive());
-  auto uniform_refresher = [this, id, name, value] {
-    if (auto it = m_programs.find(id); it != m_programs.end()) {
-      juce::OpenGLShaderProgram& program = *it->second;
-      std::visit(
-          [&program, &name](auto& arg) {
-            using T = std::decay_t<decltype(arg)>;
-            if constexpr (std::is_integral_v<T>) {
-              program.setUniform(name.c_str(), static_cast<GLint>(arg));
-            } else if constexpr (std::is_same_v<T, float>) {
-              program.setUniform(name.c_str(), arg);
-            } else if constexpr (std::is_same_v<T, glm::vec2>) {
-              program.setUniform(name.c_str(), arg.x, arg.y);
-            } else if constexpr (std::is_same_v<T, glm::mat4>) {
-              program.setUniformMat4(name.c_str(), glm::value_ptr(arg), 1,
-                                     false);
-            }
-          },
-          value);
-      return true;
-    } else {
-      fmt::println(Logger::file, R"(No program found with id "{}")", id);
-      return false;
-    }
-  };
-  bool result = uniform_refresher();
-#ifdef GLYNTH_HSR
-  m_uniform_refreshers[id][name] = std::move(uniform_refresher);
-#endif
-  return result;
+  if (auto it = m_programs.find(id); it != m_programs.end()) {
+    using namespace juce::gl;
+    slot.location =
+        glGetUniformLocation(it->second->getProgramID(), slot.name.c_str());
+  } else {
+    fmt::println(Logger::file, R"(No program found with id "{}")", id);
+    slot.location = -1;
+  }
 }
 
 void ShaderManager::markDirty(const ProgramId& id) {
@@ -142,12 +120,12 @@ void ShaderManager::tryUpdateDirty() {
           createProgram(metadata, vert_source.c_str(), frag_source.c_str());
       if (program != nullptr) {
         program->use();
-        if (m_uniform_refreshers.contains(id)) {
-          for (auto& [_, refresher] : m_uniform_refreshers.at(id)) {
-            refresher();
-          }
-        }
         m_programs.insert_or_assign(id, std::move(program));
+        // Locations can change on relink, so find them again
+        for (auto& slot : m_uniforms[id]) {
+          resolve(id, *slot);
+          slot->restore();
+        }
         m_vert_sources.insert_or_assign(id, std::move(vert_source));
         m_frag_sources.insert_or_assign(id, std::move(frag_source));
         fmt::println(Logger::file, R"(Updated shader program "{}")", id);
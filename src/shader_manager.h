@@ -1,25 +1,114 @@
 #pragma once
 
+#include <cassert>
 #include <efsw/efsw.hpp>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <juce_opengl/juce_opengl.h>
+#include <memory>
+#include <optional>
 #include <vector>
 
 #ifdef GLYNTH_HSR
 #include <filesystem>
 #endif
 
+namespace uniform_detail {
+inline void upload(GLint location, bool value) {
+  juce::gl::glUniform1i(location, value ? 1 : 0);
+}
+inline void upload(GLint location, int value) {
+  juce::gl::glUniform1i(location, value);
+}
+inline void upload(GLint location, float value) {
+  juce::gl::glUniform1f(location, value);
+}
+inline void upload(GLint location, const glm::vec2& value) {
+  juce::gl::glUniform2f(location, value.x, value.y);
+}
+inline void upload(GLint location, const glm::mat4& value) {
+  juce::gl::glUniformMatrix4fv(location, 1, juce::gl::GL_FALSE,
+                               glm::value_ptr(value));
+}
+
+// One uniform of one program. Owned by ShaderManager, so it stays put while
+// handles point to it
+struct SlotBase {
+  explicit SlotBase(std::string uniform_name) : name(std::move(uniform_name)) {}
+  virtual ~SlotBase() = default;
+  // Sets the last value again on a relinked program
+  virtual void restore() const = 0;
+
+  std::string name;
+  // -1 if the program doesn't use it, which glUniform* ignores
+  GLint location = -1;
+};
+
+template <typename T> struct Slot final : SlotBase {
+  using SlotBase::SlotBase;
+  void set(const T& value) {
+#ifdef GLYNTH_HSR
+    last = value;
+#endif
+    upload(location, value);
+  }
+  void restore() const override {
+#ifdef GLYNTH_HSR
+    if (last.has_value()) {
+      upload(location, *last);
+    }
+#endif
+  }
+
+#ifdef GLYNTH_HSR
+  std::optional<T> last;
+#endif
+};
+} // namespace uniform_detail
+
+// Typed handle to a uniform, resolved when it's first requested and again
+// whenever its program is hot reloaded. Setting it is a single glUniform*
+// call, with no lookups. Valid as long as the ShaderManager is
+template <typename T> class UniformHandle {
+public:
+  UniformHandle() = default;
+  // The program must be in use
+  inline void set(const T& value) const { m_slot->set(value); }
+
+private:
+  friend class ShaderManager;
+  explicit UniformHandle(uniform_detail::Slot<T>* slot) : m_slot(slot) {}
+
+  uniform_detail::Slot<T>* m_slot = nullptr;
+};
+
 class ShaderManager : public efsw::FileWatchListener {
 public:
   using ProgramId = std::string;
   using ShaderName = std::string;
-  using Uniform = std::variant<int, size_t, float, glm::vec2, glm::mat4>;
 
   ShaderManager(juce::OpenGLContext& context);
   bool addProgram(const ProgramId& id, const ShaderName& vert_name,
                   const ShaderName& frag_name);
   bool useProgram(const ProgramId& id);
-  bool setUniform(const ProgramId& id, const std::string& name, Uniform value);
+  // Looks the uniform up by name. Do it once, outside the render loop, and
+  // keep the handle. The program must already be added
+  template <typename T>
+  UniformHandle<T> getUniform(const ProgramId& id, const std::string& name) {
+    auto& slots = m_uniforms[id];
+    for (auto& slot : slots) {
+      if (slot->name == name) {
+        auto* typed = dynamic_cast<uniform_detail::Slot<T>*>(slot.get());
+        assert(typed != nullptr && "Uniform requested with another type");
+        return UniformHandle<T>(typed);
+      }
+    }
+    auto slot = std::make_unique<uniform_detail::Slot<T>>(name);
+    auto* typed = slot.get();
+    resolve(id, *slot);
+    slots.push_back(std::move(slot));
+    return UniformHandle<T>(typed);
+  }
   void markDirty(const ProgramId& id);
   void tryUpdateDirty();
   void handleFileAction(efsw::WatchID watchid, const std::string& dir,
@@ -46,6 +135,7 @@ private:
   std::unique_ptr<juce::OpenGLShaderProgram>
   createProgram(const ProgramMetadata& metadata, const char* vert_source,
                 const char* frag_source);
+  void resolve(const ProgramId& id, uniform_detail::SlotBase& slot);
 
   juce::OpenGLContext& m_context;
   std::unordered_map<ShaderName, std::string> m_vert_sources;
@@ -54,8 +144,8 @@ private:
       m_programs;
   std::unordered_map<ProgramId, ProgramMetadata> m_metadata;
   std::unordered_map<ProgramId,
-                     std::unordered_map<std::string, std::function<bool()>>>
-      m_uniform_refreshers;
+                     std::vector<std::unique_ptr<uniform_detail::SlotBase>>>
+      m_uniforms;
 
 #ifdef GLYNTH_HSR
   // For file watch synchronization
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+// Fixed-capacity single-producer/single-consumer ring that overwrites the
+// oldest items when full, so the producer never waits on (or fails because
+// of) the consumer. Positions are absolute item counts since construction,
+// which lets the consumer view ranges in place and then check whether the
+// producer lapped it while it was reading
+template <typename T, size_t Capacity>
+class SpscRing {
+  static_assert(std::has_single_bit(Capacity),
+                "Capacity must be a power of two");
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Items are copied with memcpy");
+
+public:
+  using Position = uint64_t;
+  // A range of the ring, split in two where it wraps around
+  using Spans = std::array<std::span<const T>, 2>;
+
+  static constexpr size_t s_capacity = Capacity;
+  static constexpr size_t s_cache_line = 64;
+
+  // Producer only. Copies items in at most two memcpy calls. Positions
+  // always advance by items.size(), even when it's over Capacity
+  void write(std::span<const T> items) {
+    Position start = m_write.load(std::memory_order_relaxed);
+    if (items.size() > Capacity) {
+      // Only the most recent items would survive anyway. Skipping the rest
+      // keeps positions in step with the producer's own counts
+      start += items.size() - Capacity;
+      items = items.last(Capacity);
+    }
+    Position end = start + items.size();
+    // Announce the overwrite before touching the data. See validate()
+    m_reserve.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    size_t offset = static_cast<size_t>(start % Capacity);
+    size_t first = std::min(items.size(), Capacity - offset);
+    std::memcpy(m_data.data() + offset, items.data(), first * sizeof(T));
+    std::memcpy(m_data.data(), items.data() + first,
+                (items.size() - first) * sizeof(T));
+    m_write.store(end, std::memory_order_release);
+  }
+
+  inline void write(const T& item) { write(std::span(&item, 1)); }
+
+  // Position one past the newest fully written item
+  inline Position end() const {
+    return m_write.load(std::memory_order_acquire);
+  }
+
+  // Position of the oldest item that hasn't been overwritten yet
+  inline Position begin() const {
+    Position w = end();
+    return w > Capacity ? w - Capacity : 0;
+  }
+
+  // Consumer only. Views [from, to) without copying. Requires
+  // begin() <= from <= to <= end()
+  Spans read(Position from, Position to) const {
+    size_t size = static_cast<size_t>(to - from);
+    size_t offset = static_cast<size_t>(from % Capacity);
+    size_t first = std::min(size, Capacity - offset);
+    return {std::span<const T>(m_data.data() + offset, first),
+            std::span<const T>(m_data.data(), size - first)};
+  }
+
+  // Consumer only. Call after reading items from a range starting at from;
+  // returns false if the producer may have overwritten any of them, in which
+  // case whatever was read should be thrown away
+  inline bool validate(Position from) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_reserve.load(std::memory_order_relaxed) - from <= Capacity;
+  }
+
+  // Consumer only. Like validate(), but returns the oldest position that
+  // hasn't been (and isn't being) overwritten, so a lapped read can keep the
+  // part of it at or after that
+  inline Position validBegin() const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    Position r = m_reserve.load(std::memory_order_relaxed);
+    return r > Capacity ? r - Capacity : 0;
+  }
+
+private:
+  // Both counters are written by the producer only, so they share a line
+  alignas(s_cache_line) std::atomic<Position> m_write = 0;
+  std::atomic<Position> m_reserve = 0;
+  alignas(s_cache_line) std::array<T, Capacity> m_data;
+};
@@ -0,0 +1,72 @@
+#include "text_batch.h"
+#include "tracer.h"
+
+#include <bit>
+#include <utility>
+
+TextBatch::TextBatch(ShaderManager& shader_manager, std::string program_id)
+    : m_shader_manager(shader_manager), m_program_id(std::move(program_id)) {
+  using namespace juce::gl;
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_vbo);
+  glGenBuffers(1, &m_ebo);
+  glBindVertexArray(m_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        reinterpret_cast<const void*>(offsetof(Vertex, uv)));
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+TextBatch::~TextBatch() {
+  using namespace juce::gl;
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteBuffers(1, &m_ebo);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void TextBatch::add(std::span<const Vertex> quads) {
+  m_vertices.insert(m_vertices.end(), quads.begin(), quads.end());
+}
+
+void TextBatch::draw(GLuint atlas_texture) {
+  GLYNTH_TRACE_SCOPE("TextBatch::draw");
+  using namespace juce::gl;
+  size_t num_quads = m_vertices.size() / 4;
+  glBindVertexArray(m_vao); // Also binds m_ebo
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  if (num_quads > m_index_capacity) {
+    // Grow to the next power of two so this rarely happens
+    m_index_capacity = std::bit_ceil(num_quads);
+    std::vector<GLuint> indices;
+    indices.reserve(6 * m_index_capacity);
+    for (GLuint i = 0; i < m_index_capacity; i++) {
+      for (GLuint offset : {0u, 1u, 2u, 0u, 2u, 3u}) {
+        indices.push_back(4 * i + offset);
+      }
+    }
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint)),
+                 indices.data(), GL_STATIC_DRAW);
+  }
+  if (m_vertices != m_uploaded) {
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(m_vertices.size() * sizeof(Vertex)),
+                 m_vertices.data(), GL_DYNAMIC_DRAW);
+    std::swap(m_vertices, m_uploaded);
+  }
+  if (num_quads > 0) {
+    m_shader_manager.useProgram(m_program_id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas_texture);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(6 * num_quads),
+                   GL_UNSIGNED_INT, nullptr);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  m_vertices.clear();
+}
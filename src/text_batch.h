@@ -0,0 +1,41 @@
+#pragma once
+
+#include "shader_manager.h"
+
+#include <glm/glm.hpp>
+#include <juce_opengl/juce_opengl.h>
+#include <span>
+#include <vector>
+
+// Collects the glyph quads of every TextComponent over a frame, then draws
+// them all with one buffer upload and one draw call. Glyphs must all come
+// from the FontManager atlas
+class TextBatch {
+public:
+  struct Vertex {
+    glm::vec2 pos;
+    glm::vec2 uv;
+
+    bool operator==(const Vertex& other) const = default;
+  };
+
+  // Create and destroy with the GL context active
+  TextBatch(ShaderManager& shader_manager, std::string program_id);
+  ~TextBatch();
+  // Quads are four vertices each, counter-clockwise from the bottom left
+  void add(std::span<const Vertex> quads);
+  // Draws everything added since the last draw, then clears the batch
+  void draw(GLuint atlas_texture);
+
+private:
+  ShaderManager& m_shader_manager;
+  std::string m_program_id;
+  GLuint m_vao = 0, m_vbo = 0, m_ebo = 0;
+  std::vector<Vertex> m_vertices;
+  // What's in the vertex buffer, so unchanged text isn't uploaded again
+  std::vector<Vertex> m_uploaded;
+  // Number of quads the element buffer has indices for
+  size_t m_index_capacity = 0;
+
+  JUCE_DECLARE_NON_COPYABLE(TextBatch)
+};
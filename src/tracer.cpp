@@ -0,0 +1,162 @@
+#include "tracer.h"
+
+#ifdef GLYNTH_TRACE
+
+#include "error.h"
+#include "rt_check.h"
+
+#include <filesystem>
+#include <fmt/format.h>
+#include <mutex>
+
+namespace {
+
+struct TraceEvent {
+  const char* name;
+  int64_t start_ns;
+  int64_t end_ns;
+};
+
+// Events recorded by one thread. Overwrites the oldest events if the drain
+// thread falls behind, so recording never blocks
+struct ThreadBuffer {
+  using Ring = SpscRing<TraceEvent, (1 << 13)>;
+
+  explicit ThreadBuffer(int thread_id, std::string default_name)
+      : tid(thread_id), default_name(std::move(default_name)),
+        name(this->default_name.c_str()) {}
+
+  Ring events;
+  const int tid;
+  const std::string default_name;
+  std::atomic<const char*> name;
+  // Drain thread state
+  Ring::Position read = 0;
+  const char* written_name = nullptr;
+};
+
+// Buffers are never freed, since a thread can keep recording after a Tracer
+// is destroyed or while statics are being torn down
+std::mutex& registryLock() {
+  static auto* lock = new std::mutex;
+  return *lock;
+}
+
+std::vector<ThreadBuffer*>& registry() {
+  static auto* buffers = new std::vector<ThreadBuffer*>;
+  return *buffers;
+}
+
+ThreadBuffer& localBuffer() {
+  thread_local ThreadBuffer* buffer = [] {
+    // Allocates once per thread, which is the price of not preregistering
+    GLYNTH_RT_EXEMPT();
+    std::string name;
+    if (auto* thread = juce::Thread::getCurrentThread()) {
+      name = thread->getThreadName().toStdString();
+    } else if (juce::MessageManager::existsAndIsCurrentThread()) {
+      name = "Message";
+    }
+    const std::lock_guard lock(registryLock());
+    int tid = static_cast<int>(registry().size()) + 1;
+    if (name.empty()) {
+      name = fmt::format("Thread {}", tid);
+    }
+    return registry().emplace_back(new ThreadBuffer(tid, std::move(name)));
+  }();
+  return *buffer;
+}
+
+} // namespace
+
+Tracer::Tracer() : juce::Thread("Glynth Tracer") {
+  auto dir = std::filesystem::path(GLYNTH_LOG_DIR);
+  std::filesystem::create_directories(dir);
+  auto time = juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S");
+  auto path = dir / fmt::format("trace-{}.json", time.toStdString());
+  m_file = fopen(path.c_str(), "w");
+  if (m_file == nullptr) {
+    throw GlynthError(fmt::format(R"(Unable to open "{}")", path.string()));
+  }
+  // The array format doesn't require the closing bracket, so the file is
+  // still usable if the process dies before the destructor runs
+  fmt::print(m_file, "[\n");
+  {
+    // Skip anything recorded while no tracer was running
+    const std::lock_guard lock(registryLock());
+    for (auto* buffer : registry()) {
+      buffer->read = buffer->events.end();
+      buffer->written_name = nullptr;
+    }
+  }
+  startThread(juce::Thread::Priority::background);
+}
+
+Tracer::~Tracer() {
+  stopThread(1000);
+  drain();
+  fmt::print(m_file, "\n]\n");
+  fclose(m_file);
+}
+
+void Tracer::record(const char* name, int64_t start_ns, int64_t end_ns) {
+  localBuffer().events.write(TraceEvent{name, start_ns, end_ns});
+}
+
+void Tracer::setThreadName(const char* name) {
+  localBuffer().name.store(name, std::memory_order_release);
+}
+
+void Tracer::run() {
+  while (!threadShouldExit()) {
+    drain();
+    wait(s_drain_interval_ms);
+  }
+}
+
+void Tracer::drain() {
+  std::vector<ThreadBuffer*> buffers;
+  {
+    const std::lock_guard lock(registryLock());
+    buffers = registry();
+  }
+  std::vector<TraceEvent> events;
+  for (auto* buffer : buffers) {
+    auto* sep = m_first_event ? "" : ",\n";
+    auto* name = buffer->name.load(std::memory_order_acquire);
+    if (name != buffer->written_name) {
+      fmt::print(m_file,
+                 R"({}{{"name": "thread_name", "ph": "M", "pid": 1, )"
+                 R"("tid": {}, "args": {{"name": "{}"}}}})",
+                 sep, buffer->tid, name);
+      buffer->written_name = name;
+      m_first_event = false;
+    }
+
+    auto from = std::max(buffer->read, buffer->events.begin());
+    auto to = buffer->events.end();
+    events.clear();
+    for (auto span : buffer->events.read(from, to)) {
+      events.insert(events.end(), span.begin(), span.end());
+    }
+    buffer->read = to;
+    if (!buffer->events.validate(from)) {
+      // Lapped while copying, so some of these may be torn
+      continue;
+    }
+    for (auto& event : events) {
+      sep = m_first_event ? "" : ",\n";
+      // Timestamps are in microseconds
+      fmt::print(m_file,
+                 R"({}{{"name": "{}", "ph": "X", "pid": 1, "tid": {}, )"
+                 R"("ts": {:.3f}, "dur": {:.3f}}})",
+                 sep, event.name, buffer->tid,
+                 static_cast<double>(event.start_ns) / 1e3,
+                 static_cast<double>(event.end_ns - event.start_ns) / 1e3);
+      m_first_event = false;
+    }
+  }
+  fflush(m_file);
+}
+
+#endif
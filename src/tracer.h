@@ -0,0 +1,73 @@
+#pragma once
+
+// Scoped trace markers exported as Chrome trace events, viewable in
+// chrome://tracing or https://ui.perfetto.dev. Everything compiles away
+// unless built with GLYNTH_TRACE, so markers can stay in hot paths
+//
+//   GLYNTH_TRACE_THREAD("Audio");     // Names the calling thread
+//   GLYNTH_TRACE_SCOPE("processBlock"); // Times the enclosing scope
+//
+// Names must be string literals since only the pointer is recorded
+
+#ifdef GLYNTH_TRACE
+
+#include "spsc_ring.h"
+
+#include <chrono>
+#include <cstdio>
+#include <juce_core/juce_core.h>
+#include <string>
+#include <vector>
+
+// Drains the per-thread event buffers into a JSON file under GLYNTH_LOG_DIR
+// while at least one instance exists. Shared by all plugin instances through
+// juce::SharedResourcePointer<Tracer>
+class Tracer : private juce::Thread {
+public:
+  Tracer();
+  ~Tracer() override;
+
+  inline static int64_t now() {
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+  }
+  // Records a complete event on the calling thread without locking or
+  // allocating, apart from registering the thread the first time
+  static void record(const char* name, int64_t start_ns, int64_t end_ns);
+  static void setThreadName(const char* name);
+
+private:
+  static constexpr int s_drain_interval_ms = 100;
+
+  void run() override;
+  void drain();
+
+  FILE* m_file = nullptr;
+  bool m_first_event = true;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Tracer)
+};
+
+class TraceScope {
+public:
+  explicit TraceScope(const char* name)
+      : m_name(name), m_start_ns(Tracer::now()) {}
+  ~TraceScope() { Tracer::record(m_name, m_start_ns, Tracer::now()); }
+
+private:
+  const char* m_name;
+  int64_t m_start_ns;
+};
+
+#define GLYNTH_TRACE_CONCAT_INNER(a, b) a##b
+#define GLYNTH_TRACE_CONCAT(a, b) GLYNTH_TRACE_CONCAT_INNER(a, b)
+#define GLYNTH_TRACE_SCOPE(name)                                               \
+  TraceScope GLYNTH_TRACE_CONCAT(glynth_trace_scope_, __LINE__)(name)
+#define GLYNTH_TRACE_THREAD(name) Tracer::setThreadName(name)
+
+#else
+
+#define GLYNTH_TRACE_SCOPE(name)
+#define GLYNTH_TRACE_THREAD(name)
+
+#endif
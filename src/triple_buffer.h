@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free handoff of the latest value from one producer thread to one
+// consumer thread. The three buffers are allocated once and then rotate
+// between the producer, the consumer, and a shared middle slot, so neither
+// side ever waits on or allocates for the other
+template <typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() = default;
+  explicit TripleBuffer(const T& initial)
+      : m_buffers{initial, initial, initial} {}
+
+  // Not thread-safe, so only use before sharing with other threads
+  template <typename F>
+  void forEach(F&& f) {
+    for (auto& buffer : m_buffers) {
+      f(buffer);
+    }
+  }
+
+  // Producer only. The buffer to fill before calling publish()
+  inline T& back() { return m_buffers[m_back]; }
+
+  // Producer only. Makes the back buffer the newest value
+  inline void publish() {
+    auto middle = static_cast<uint8_t>(m_back | s_new);
+    auto prev = m_middle.exchange(middle, std::memory_order_acq_rel);
+    m_back = static_cast<uint8_t>(prev & s_index);
+  }
+
+  // Consumer only. Returns the newest value if one was published since the
+  // last call, or nullptr otherwise. The pointer stays valid until the next
+  // call to acquire()
+  inline T* acquire() {
+    if (!(m_middle.load(std::memory_order_relaxed) & s_new)) {
+      return nullptr;
+    }
+    auto prev = m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = static_cast<uint8_t>(prev & s_index);
+    return &m_buffers[m_front];
+  }
+
+  // Whether acquire() would return a new value. Only reads the shared flag,
+  // so any thread may call it, although the answer is only a hint to
+  // threads other than the consumer
+  inline bool pending() const {
+    return m_middle.load(std::memory_order_relaxed) & s_new;
+  }
+
+private:
+  static constexpr uint8_t s_index = 0b011;
+  static constexpr uint8_t s_new = 0b100;
+  static constexpr size_t s_cache_line = 64;
+
+  std::array<T, 3> m_buffers;
+  alignas(s_cache_line) std::atomic<uint8_t> m_middle = 1;
+  // Each side owns one index, kept on separate lines to avoid false sharing
+  alignas(s_cache_line) uint8_t m_back = 0;
+  alignas(s_cache_line) uint8_t m_front = 2;
+};